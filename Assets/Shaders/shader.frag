@@ -56,7 +56,14 @@ uniform SpotLight spotLights[MAX_SPOT_LIGHTS];
 uniform sampler2D mainTexture;
 uniform Material material;
 
-uniform vec3 eyePos;	// The position of the camera
+// Written once per view and shared by every program, see UniformBlocks.h
+layout (std140) uniform ViewData
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 eyePosition;	// The position of the camera
+};
 
 vec4 CalcLightByDirection(Light light, vec3 direction)
 {
@@ -71,7 +78,7 @@ vec4 CalcLightByDirection(Light light, vec3 direction)
 	if (diffuseFactor > 0.0f)
 	{
 		// Get the direction from the fragment to the eye
-		vec3 fragToEye = normalize(eyePos - FragPos);
+		vec3 fragToEye = normalize(eyePosition.xyz - FragPos);
 		// Calculate the reflection vector
 		vec3 reflectedLight = normalize( reflect( -normalize( direction ), normalize( Normal ) ) );
 
@@ -4,25 +4,40 @@ layout (location = 0) in vec3 pos;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 tex;
 
+// Rows of the affine world matrix of each instance, read instead of model when instanced is set
+layout (location = 3) in vec4 instanceRow0;
+layout (location = 4) in vec4 instanceRow1;
+layout (location = 5) in vec4 instanceRow2;
+
 out vec4 vCol;
 out vec2 TexCoord;
 out vec3 Normal;		// You could add flat here to make it flat shading (flat out vec3 Normal)
 out vec3 FragPos;
 
-uniform mat4 model;
-uniform mat4 projection;
-uniform mat4 view;
+uniform mat4x3 model;	// Affine world matrix, the last row is always (0, 0, 0, 1)
+uniform bool instanced;
+
+// Written once per view and shared by every program, see UniformBlocks.h
+layout (std140) uniform ViewData
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 eyePosition;
+};
 
 void main()
 {
+	mat4x3 world = instanced ? transpose(mat3x4(instanceRow0, instanceRow1, instanceRow2)) : model;
+
 	// Transform the vertex position into world space
-	vec4 WorldPos = model * vec4(pos, 1.0f);
+	vec4 WorldPos = vec4(world * vec4(pos, 1.0f), 1.0f);
 
 	vCol = vec4(clamp(pos, 0.0f, 1.0f), 1.0f);			// Pass the interpolated vertex color to the fragment shader
 	TexCoord = tex;										// Pass the interpolated vertex texture coordinates to the fragment shader
-	Normal = mat3(transpose(inverse(model))) * normal;	// Transpose inverse matrix to transform normals correctly regardless of scale
+	Normal = transpose(inverse(mat3(world))) * normal;	// Transpose inverse matrix to transform normals correctly regardless of scale
 	FragPos = WorldPos.xyz;								// Pass the fragment position to the fragment shader
 
 	// Return the transformed and projected vertex value in clip space
-	gl_Position = projection * view * WorldPos;
+	gl_Position = viewProjection * WorldPos;
 }
\ No newline at end of file
@@ -0,0 +1,432 @@
+#include "../Public/AABBTree.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace Vosgi
+{
+    namespace
+    {
+        float SurfaceArea(const glm::vec3& min, const glm::vec3& max)
+        {
+            const glm::vec3 size = max - min;
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        bool Contains(const glm::vec3& outerMin, const glm::vec3& outerMax, const glm::vec3& min, const glm::vec3& max)
+        {
+            return outerMin.x <= min.x && outerMin.y <= min.y && outerMin.z <= min.z &&
+                   max.x <= outerMax.x && max.y <= outerMax.y && max.z <= outerMax.z;
+        }
+    }
+
+    AABBTree::AABBTree() = default;
+
+    AABBTree& AABBTree::Main()
+    {
+        static AABBTree tree;
+        return tree;
+    }
+
+    AABBTree::ProxyId AABBTree::CreateProxy(const glm::vec3& min, const glm::vec3& max, void* userData)
+    {
+        const int32_t proxy = AllocateNode();
+
+        Node& node = nodes[proxy];
+        node.min = min - glm::vec3(margin);
+        node.max = max + glm::vec3(margin);
+        node.userData = userData;
+        node.height = 0;
+
+        if (leafSlots.size() < nodes.size()) leafSlots.resize(nodes.size(), -1);
+        leafSlots[proxy] = static_cast<int32_t>(leafProxies.size());
+        leafProxies.push_back(proxy);
+        leafData.push_back(userData);
+        leafBounds.ForEachArray([](std::vector<float>& values) { values.push_back(0.0f); });
+        StoreLeafBounds(proxy);
+
+        InsertLeaf(proxy);
+        ++proxyCount;
+        ++version;
+        ++membershipVersion;
+        return proxy;
+    }
+
+    void AABBTree::DestroyProxy(ProxyId proxy)
+    {
+        // The last leaf fills the hole
+        const int32_t slot = leafSlots[proxy];
+        const ProxyId last = leafProxies.back();
+        leafBounds.ForEachArray([slot](std::vector<float>& values) {
+            values[slot] = values.back();
+            values.pop_back();
+        });
+        leafProxies[slot] = last;
+        leafProxies.pop_back();
+        leafData[slot] = leafData.back();
+        leafData.pop_back();
+        leafSlots[last] = slot;
+        leafSlots[proxy] = -1;
+
+        RemoveLeaf(proxy);
+        FreeNode(proxy);
+        --proxyCount;
+        ++version;
+        ++membershipVersion;
+    }
+
+    bool AABBTree::MoveProxy(ProxyId proxy, const glm::vec3& min, const glm::vec3& max)
+    {
+        Node& node = nodes[proxy];
+
+        // Keep the leaf while its fattened box still encloses the new box and is not much larger
+        const glm::vec3 largeMargin(4.0f * margin);
+        if (Contains(node.min, node.max, min, max) && Contains(min - largeMargin, max + largeMargin, node.min, node.max))
+        {
+            return false;
+        }
+
+        RemoveLeaf(proxy);
+        nodes[proxy].min = min - glm::vec3(margin);
+        nodes[proxy].max = max + glm::vec3(margin);
+        StoreLeafBounds(proxy);
+        InsertLeaf(proxy);
+
+        ++version;
+        return true;
+    }
+
+    void AABBTree::Rebalance(uint32_t iterations)
+    {
+        const auto count = static_cast<uint32_t>(nodes.size());
+        if (proxyCount < 2) return;
+
+        // Reinserting a leaf does not change its box, so query results stay valid
+        for (uint32_t visited = 0; iterations > 0 && visited < count; ++visited)
+        {
+            rebalanceCursor = (rebalanceCursor + 1) % count;
+            const Node& node = nodes[rebalanceCursor];
+            if (node.height != 0) continue;
+
+            RemoveLeaf(static_cast<int32_t>(rebalanceCursor));
+            InsertLeaf(static_cast<int32_t>(rebalanceCursor));
+            --iterations;
+        }
+    }
+
+    Culling::PlaneStats AABBTree::QueryFrustum(const Frustum& frustum, std::vector<void*>& out)
+    {
+        Culling::PlaneStats stats;
+        if (root == NullProxy) return stats;
+
+        const size_t first = out.size();
+
+        // Past a few percent visible, testing every leaf side by side beats chasing the nodes
+        if (static_cast<float>(lastVisible) > static_cast<float>(proxyCount) * scanFraction)
+        {
+            stats.boxes = proxyCount;
+            stats.planes = proxyCount * 6;
+
+            Culling::FrustumCull(frustum, leafBounds, scanVisibility);
+            Culling::ForEachVisible(scanVisibility, [this, &out](size_t slot) { out.push_back(leafData[slot]); });
+
+            lastVisible = out.size() - first;
+            return stats;
+        }
+
+        stack.clear();
+        stack.emplace_back(root, Culling::AllPlanes);
+
+        while (!stack.empty())
+        {
+            auto [index, mask] = stack.back();
+            stack.pop_back();
+
+            Node& node = nodes[index];
+            if (!Culling::TestPlanes(frustum, (node.min + node.max) * 0.5f, (node.max - node.min) * 0.5f, mask, node.rejectingPlane, stats)) continue;
+
+            if (node.IsLeaf())
+            {
+                out.push_back(node.userData);
+                continue;
+            }
+
+            if (mask != 0)
+            {
+                stack.emplace_back(node.child1, mask);
+                stack.emplace_back(node.child2, mask);
+                continue;
+            }
+
+            // Fully inside, every leaf below is visible without further tests
+            subtree.push_back(index);
+            while (!subtree.empty())
+            {
+                const Node& inside = nodes[subtree.back()];
+                subtree.pop_back();
+
+                if (inside.IsLeaf())
+                {
+                    out.push_back(inside.userData);
+                }
+                else
+                {
+                    subtree.push_back(inside.child1);
+                    subtree.push_back(inside.child2);
+                }
+            }
+        }
+
+        lastVisible = out.size() - first;
+        return stats;
+    }
+
+    void AABBTree::StoreLeafBounds(ProxyId proxy)
+    {
+        const Node& node = nodes[proxy];
+        const glm::vec3 center = (node.min + node.max) * 0.5f;
+        const glm::vec3 extents = (node.max - node.min) * 0.5f;
+
+        const auto slot = static_cast<size_t>(leafSlots[proxy]);
+        leafBounds.centerX[slot] = center.x, leafBounds.centerY[slot] = center.y, leafBounds.centerZ[slot] = center.z;
+        leafBounds.extentX[slot] = extents.x, leafBounds.extentY[slot] = extents.y, leafBounds.extentZ[slot] = extents.z;
+    }
+
+    int32_t AABBTree::AllocateNode()
+    {
+        if (freeList == NullProxy)
+        {
+            nodes.emplace_back();
+            return static_cast<int32_t>(nodes.size() - 1);
+        }
+
+        const int32_t node = freeList;
+        freeList = nodes[node].parentOrNext;
+        nodes[node] = Node();
+        return node;
+    }
+
+    void AABBTree::FreeNode(int32_t node)
+    {
+        nodes[node].parentOrNext = freeList;
+        nodes[node].height = -1;
+        nodes[node].userData = nullptr;
+        freeList = node;
+    }
+
+    void AABBTree::InsertLeaf(int32_t leaf)
+    {
+        if (root == NullProxy)
+        {
+            root = leaf;
+            nodes[leaf].parentOrNext = NullProxy;
+            return;
+        }
+
+        // Descend towards the sibling that grows the total surface area the least
+        const glm::vec3 leafMin = nodes[leaf].min, leafMax = nodes[leaf].max;
+        int32_t index = root;
+        while (!nodes[index].IsLeaf())
+        {
+            const Node& node = nodes[index];
+
+            const float area = SurfaceArea(node.min, node.max);
+            const float combinedArea = SurfaceArea(glm::min(node.min, leafMin), glm::max(node.max, leafMax));
+
+            // Cost of pairing the leaf with this node, and of pushing it further down
+            const float cost = 2.0f * combinedArea;
+            const float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto descendCost = [&](int32_t childIndex) {
+                const Node& child = nodes[childIndex];
+                const float enlarged = SurfaceArea(glm::min(child.min, leafMin), glm::max(child.max, leafMax));
+                return (child.IsLeaf() ? enlarged : enlarged - SurfaceArea(child.min, child.max)) + inheritanceCost;
+            };
+            const float cost1 = descendCost(node.child1);
+            const float cost2 = descendCost(node.child2);
+
+            if (cost < cost1 && cost < cost2) break;
+            index = cost1 < cost2 ? node.child1 : node.child2;
+        }
+
+        const int32_t sibling = index;
+        const int32_t oldParent = nodes[sibling].parentOrNext;
+        const int32_t newParent = AllocateNode();
+
+        Node& parent = nodes[newParent];
+        parent.parentOrNext = oldParent;
+        parent.min = glm::min(nodes[sibling].min, leafMin);
+        parent.max = glm::max(nodes[sibling].max, leafMax);
+        parent.height = nodes[sibling].height + 1;
+        parent.child1 = sibling;
+        parent.child2 = leaf;
+        nodes[sibling].parentOrNext = newParent;
+        nodes[leaf].parentOrNext = newParent;
+
+        if (oldParent == NullProxy)
+        {
+            root = newParent;
+        }
+        else if (nodes[oldParent].child1 == sibling)
+        {
+            nodes[oldParent].child1 = newParent;
+        }
+        else
+        {
+            nodes[oldParent].child2 = newParent;
+        }
+
+        SyncAncestors(nodes[leaf].parentOrNext);
+    }
+
+    void AABBTree::RemoveLeaf(int32_t leaf)
+    {
+        if (leaf == root)
+        {
+            root = NullProxy;
+            return;
+        }
+
+        // The parent goes away and the sibling takes its place
+        const int32_t parent = nodes[leaf].parentOrNext;
+        const int32_t grandParent = nodes[parent].parentOrNext;
+        const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        nodes[sibling].parentOrNext = grandParent;
+        FreeNode(parent);
+
+        if (grandParent == NullProxy)
+        {
+            root = sibling;
+            return;
+        }
+
+        if (nodes[grandParent].child1 == parent)
+        {
+            nodes[grandParent].child1 = sibling;
+        }
+        else
+        {
+            nodes[grandParent].child2 = sibling;
+        }
+        SyncAncestors(grandParent);
+    }
+
+    void AABBTree::SyncAncestors(int32_t index)
+    {
+        while (index != NullProxy)
+        {
+            index = Balance(index);
+
+            Node& node = nodes[index];
+            const Node& child1 = nodes[node.child1];
+            const Node& child2 = nodes[node.child2];
+            node.height = 1 + std::max(child1.height, child2.height);
+            node.min = glm::min(child1.min, child2.min);
+            node.max = glm::max(child1.max, child2.max);
+
+            index = node.parentOrNext;
+        }
+    }
+
+    int32_t AABBTree::Balance(int32_t indexA)
+    {
+        Node& a = nodes[indexA];
+        if (a.IsLeaf() || a.height < 2) return indexA;
+
+        const int32_t indexB = a.child1;
+        const int32_t indexC = a.child2;
+        Node& b = nodes[indexB];
+        Node& c = nodes[indexC];
+
+        // Move the taller child up to replace a, and give a its shorter grandchild
+        const int32_t balance = c.height - b.height;
+        if (balance > 1)
+        {
+            const int32_t indexF = c.child1;
+            const int32_t indexG = c.child2;
+            Node& f = nodes[indexF];
+            Node& g = nodes[indexG];
+
+            c.child1 = indexA;
+            c.parentOrNext = a.parentOrNext;
+            a.parentOrNext = indexC;
+
+            if (c.parentOrNext == NullProxy)
+            {
+                root = indexC;
+            }
+            else if (nodes[c.parentOrNext].child1 == indexA)
+            {
+                nodes[c.parentOrNext].child1 = indexC;
+            }
+            else
+            {
+                nodes[c.parentOrNext].child2 = indexC;
+            }
+
+            const bool keepF = f.height > g.height;
+            const int32_t indexKept = keepF ? indexF : indexG;
+            const int32_t indexMoved = keepF ? indexG : indexF;
+            Node& kept = nodes[indexKept];
+            Node& moved = nodes[indexMoved];
+
+            c.child2 = indexKept;
+            a.child2 = indexMoved;
+            moved.parentOrNext = indexA;
+
+            a.min = glm::min(b.min, moved.min);
+            a.max = glm::max(b.max, moved.max);
+            a.height = 1 + std::max(b.height, moved.height);
+            c.min = glm::min(a.min, kept.min);
+            c.max = glm::max(a.max, kept.max);
+            c.height = 1 + std::max(a.height, kept.height);
+            return indexC;
+        }
+
+        if (balance < -1)
+        {
+            const int32_t indexD = b.child1;
+            const int32_t indexE = b.child2;
+            Node& d = nodes[indexD];
+            Node& e = nodes[indexE];
+
+            b.child1 = indexA;
+            b.parentOrNext = a.parentOrNext;
+            a.parentOrNext = indexB;
+
+            if (b.parentOrNext == NullProxy)
+            {
+                root = indexB;
+            }
+            else if (nodes[b.parentOrNext].child1 == indexA)
+            {
+                nodes[b.parentOrNext].child1 = indexB;
+            }
+            else
+            {
+                nodes[b.parentOrNext].child2 = indexB;
+            }
+
+            const bool keepD = d.height > e.height;
+            const int32_t indexKept = keepD ? indexD : indexE;
+            const int32_t indexMoved = keepD ? indexE : indexD;
+            Node& kept = nodes[indexKept];
+            Node& moved = nodes[indexMoved];
+
+            b.child2 = indexKept;
+            a.child1 = indexMoved;
+            moved.parentOrNext = indexA;
+
+            a.min = glm::min(c.min, moved.min);
+            a.max = glm::max(c.max, moved.max);
+            a.height = 1 + std::max(c.height, moved.height);
+            b.min = glm::min(a.min, kept.min);
+            b.max = glm::max(a.max, kept.max);
+            b.height = 1 + std::max(a.height, kept.height);
+            return indexB;
+        }
+
+        return indexA;
+    }
+} // namespace Vosgi
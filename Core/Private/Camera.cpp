@@ -2,6 +2,7 @@
 
 #include "../Public/Frustum.h"
 #include "../Public/Shader.h"
+#include "../Public/UniformBlocks.h"
 
 Camera::Camera() : Vosgi::Behaviour()
 {
@@ -50,25 +51,25 @@ void Camera::keyControl(bool *keys, GLfloat deltaTime)
 
     if (keys[GLFW_KEY_W])
     {
-        transform->position -= transform->GetForward() * velocity;
+        transform->position -= transform->GetLocalForward() * velocity;
         transform->SetDirty();
     }
 
     if (keys[GLFW_KEY_S])
     {
-        transform->position += transform->GetForward() * velocity;
+        transform->position += transform->GetLocalForward() * velocity;
         transform->SetDirty();
     }
 
     if (keys[GLFW_KEY_A])
     {
-        transform->position -= transform->GetRight() * velocity;
+        transform->position -= transform->GetLocalRight() * velocity;
         transform->SetDirty();
     }
 
     if (keys[GLFW_KEY_D])
     {
-        transform->position += transform->GetRight() * velocity;
+        transform->position += transform->GetLocalRight() * velocity;
         transform->SetDirty();
     }
 
@@ -93,7 +94,7 @@ void Camera::mouseControl(GLfloat xChange, GLfloat yChange)
     glm::quat rotation = transform->rotation;
 
     // create rotation quaternion
-    glm::quat pitch = glm::angleAxis(glm::radians(yChange), transform->GetRight());
+    glm::quat pitch = glm::angleAxis(glm::radians(yChange), transform->GetLocalRight());
     glm::quat yaw = glm::angleAxis(glm::radians(xChange), worldUp);
 
     // apply rotation
@@ -102,16 +103,15 @@ void Camera::mouseControl(GLfloat xChange, GLfloat yChange)
     transform->SetRotation(rotation);
 }
 
-void Camera::Update(float deltaTime)
+void Camera::Draw(const Frustum& frustum, Shader& shader, unsigned int& display, unsigned int& draw)
 {
-    // Set the projection matrix
-    Shader::SetGlobalMat4("projection", projection);
-
-    // Set the view matrix
-    Shader::SetGlobalMat4("view", calculateViewMatrix());
-
-    // Set the camera position
-    Shader::SetGlobalVec3("eyePos", getCameraPosition());
+    // Written once for all programs, bound to the view block binding point
+    Vosgi::UniformBlocks::ViewData viewData;
+    viewData.view = calculateViewMatrix();
+    viewData.projection = projection;
+    viewData.viewProjection = getViewProjectionMatrix();
+    viewData.eyePosition = glm::vec4(getCameraPosition(), 1.0f);
+    Vosgi::UniformBlocks::SetView(viewData);
 }
 
 void Camera::DrawInspector()
@@ -125,28 +125,39 @@ void Camera::DrawInspector()
         setFov(currentFOV);
     }
 
-    ImGui::SliderFloat("Near Plane", &nearPlane, 0.f, 10.f);
-    ImGui::SliderFloat("Far Plane", &farPlane, 0.f, 100.f);
+    bool planesChanged = ImGui::SliderFloat("Near Plane", &nearPlane, 0.f, 10.f);
+    planesChanged |= ImGui::SliderFloat("Far Plane", &farPlane, 0.f, 100.f);
+    if (planesChanged)
+    {
+        setFov(fov);
+    }
 }
 
-// TODO: Cache frustum planes
-Frustum Camera::getFrustum() const
+const Frustum& Camera::getFrustum() const
 {
-    Frustum frustum;
-    const float halfVSide = farPlane * tanf(glm::radians(fov) * .5f);
-    const float halfHSide = halfVSide * aspectRatio;
-    const glm::vec3 frontMultFar = farPlane * -getFront();
-
-    frustum.nearFace = {getCameraPosition() + nearPlane * -getFront(), -getFront()};
-    frustum.farFace = {getCameraPosition() + frontMultFar, getFront()};
-    frustum.rightFace = {getCameraPosition(), glm::cross(frontMultFar - getRight() * halfHSide, getUp())};
-    frustum.leftFace = {getCameraPosition(), glm::cross(getUp(), frontMultFar + getRight() * halfHSide)};
-    frustum.topFace = {getCameraPosition(), glm::cross(getRight(), frontMultFar - getUp() * halfVSide)};
-    frustum.bottomFace = {getCameraPosition(), glm::cross(frontMultFar + getUp() * halfVSide, getRight())};
-
+    updateFrustum();
     return frustum;
 }
 
+const glm::mat4& Camera::getViewProjectionMatrix() const
+{
+    updateFrustum();
+    return viewProjection;
+}
+
+void Camera::updateFrustum() const
+{
+    // A still camera keeps its planes
+    const Vosgi::Affine& world = transform->GetModel();
+    if (frustumValid && world == frustumWorld && projection == frustumProjection) return;
+
+    viewProjection = projection * calculateViewMatrix();
+    frustum = Frustum::FromMatrix(viewProjection);
+    frustumWorld = world;
+    frustumProjection = projection;
+    frustumValid = true;
+}
+
 Camera::~Camera()
 {
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "../Public/ComponentPool.h"
+#include "../Public/EntityPool.h"
+#include "../Public/GUIDRegistry.h"
+
+namespace Vosgi
+{
+    std::vector<ComponentPoolBase*> ComponentPoolBase::pools = std::vector<ComponentPoolBase*>();
+    ComponentTypeId ComponentPoolBase::typeCount = 0;
+
+    ComponentPoolBase::ComponentPoolBase(ComponentTypeId typeId) : typeId(typeId)
+    {
+        if (pools.size() <= typeId)
+        {
+            pools.resize(typeId + 1, nullptr);
+        }
+        pools[typeId] = this;
+    }
+
+    void ComponentPoolBase::Register(Behaviour* behaviour, uint32_t slot)
+    {
+        behaviour->componentType = typeId;
+        behaviour->poolSlot = slot;
+        behaviour->poolIndex = static_cast<uint32_t>(dense.size());
+        dense.push_back(behaviour);
+
+        GUIDRegistry::Register(behaviour->guid, behaviour);
+    }
+
+    void ComponentPoolBase::Unregister(Behaviour* behaviour)
+    {
+        GUIDRegistry::Unregister(behaviour->guid);
+
+        // Swap with the last behaviour to keep the array dense
+        const uint32_t index = behaviour->poolIndex;
+        Behaviour* last = dense.back();
+        dense[index] = last;
+        last->poolIndex = index;
+        dense.pop_back();
+    }
+
+    void ComponentPoolBase::ReleaseEntities()
+    {
+        EntityPool& entityPool = EntityPool::Instance();
+        entityPool.DestroyAll();
+        entityPool.FlushDestroyed();
+    }
+} // namespace Vosgi
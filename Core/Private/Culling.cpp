@@ -0,0 +1,391 @@
+#include "../Public/Culling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../Public/SIMD.h"
+
+namespace Vosgi
+{
+    namespace Culling
+    {
+        namespace
+        {
+            // A plane with the absolute normal precomputed, for the box projection radius
+            struct PackedPlane
+            {
+                float nx, ny, nz;
+                float ax, ay, az;
+                float distance;
+            };
+
+            struct Streams
+            {
+                const float *cx, *cy, *cz;
+                const float *ex, *ey, *ez;
+            };
+
+            // Side planes first, they reject the most
+            void PackPlanes(const Frustum& frustum, PackedPlane (&planes)[6])
+            {
+                const Plane* faces[6] = {&frustum.leftFace, &frustum.rightFace, &frustum.farFace,
+                                         &frustum.nearFace, &frustum.topFace, &frustum.bottomFace};
+                for (int i = 0; i < 6; ++i)
+                {
+                    const glm::vec3& n = faces[i]->normal;
+                    planes[i] = {n.x, n.y, n.z, std::abs(n.x), std::abs(n.y), std::abs(n.z), faces[i]->distance};
+                }
+            }
+
+            Streams GetStreams(const BoundsArrays& bounds)
+            {
+                return {
+                    bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(),
+                    bounds.extentX.data(), bounds.extentY.data(), bounds.extentZ.data(),
+                };
+            }
+
+            void CullScalar(const PackedPlane (&planes)[6], const Streams& s, size_t begin, size_t end, uint32_t* visibility)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    // Branchless, every plane is tested so the loop does not mispredict
+                    bool inside = true;
+                    for (const auto& p : planes)
+                    {
+                        const float distance = p.nx * s.cx[i] + p.ny * s.cy[i] + p.nz * s.cz[i] - p.distance;
+                        const float radius = p.ax * s.ex[i] + p.ay * s.ey[i] + p.az * s.ez[i];
+                        inside &= distance + radius >= 0.0f;
+                    }
+                    visibility[i / 32] |= static_cast<uint32_t>(inside) << (i % 32);
+                }
+            }
+
+#if VOSGI_SIMD_X86
+            void CullSSE2(const PackedPlane (&planes)[6], const Streams& s, size_t count, uint32_t* visibility)
+            {
+                const __m128 zero = _mm_setzero_ps();
+
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    const __m128 cx = _mm_loadu_ps(s.cx + i), cy = _mm_loadu_ps(s.cy + i), cz = _mm_loadu_ps(s.cz + i);
+                    const __m128 ex = _mm_loadu_ps(s.ex + i), ey = _mm_loadu_ps(s.ey + i), ez = _mm_loadu_ps(s.ez + i);
+
+                    __m128 inside = _mm_cmpeq_ps(zero, zero);
+                    for (const auto& p : planes)
+                    {
+                        // distance + radius = n.c + |n|.e - d
+                        __m128 sum = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(p.nx), cx), _mm_set1_ps(p.distance));
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(p.ny), cy));
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(p.nz), cz));
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(p.ax), ex));
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(p.ay), ey));
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(p.az), ez));
+                        inside = _mm_and_ps(inside, _mm_cmpge_ps(sum, zero));
+                    }
+                    visibility[i / 32] |= static_cast<uint32_t>(_mm_movemask_ps(inside)) << (i % 32);
+                }
+
+                CullScalar(planes, s, i, count, visibility);
+            }
+
+            VOSGI_TARGET_AVX2 void CullAVX2(const PackedPlane (&planes)[6], const Streams& s, size_t count, uint32_t* visibility)
+            {
+                const __m256 zero = _mm256_setzero_ps();
+
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8)
+                {
+                    const __m256 cx = _mm256_loadu_ps(s.cx + i), cy = _mm256_loadu_ps(s.cy + i), cz = _mm256_loadu_ps(s.cz + i);
+                    const __m256 ex = _mm256_loadu_ps(s.ex + i), ey = _mm256_loadu_ps(s.ey + i), ez = _mm256_loadu_ps(s.ez + i);
+
+                    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                    for (const auto& p : planes)
+                    {
+                        __m256 sum = _mm256_fmsub_ps(_mm256_set1_ps(p.nx), cx, _mm256_set1_ps(p.distance));
+                        sum = _mm256_fmadd_ps(_mm256_set1_ps(p.ny), cy, sum);
+                        sum = _mm256_fmadd_ps(_mm256_set1_ps(p.nz), cz, sum);
+                        sum = _mm256_fmadd_ps(_mm256_set1_ps(p.ax), ex, sum);
+                        sum = _mm256_fmadd_ps(_mm256_set1_ps(p.ay), ey, sum);
+                        sum = _mm256_fmadd_ps(_mm256_set1_ps(p.az), ez, sum);
+                        inside = _mm256_and_ps(inside, _mm256_cmp_ps(sum, zero, _CMP_GE_OQ));
+                    }
+                    visibility[i / 32] |= static_cast<uint32_t>(_mm256_movemask_ps(inside)) << (i % 32);
+                }
+
+                CullScalar(planes, s, i, count, visibility);
+            }
+#endif
+
+            void MultiCullScalar(const PackedPlane (*views)[6], size_t viewCount, const Streams& s, size_t begin, size_t end, ViewMask* masks)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    ViewMask mask = 0;
+                    for (size_t v = 0; v < viewCount; ++v)
+                    {
+                        bool inside = true;
+                        for (const auto& p : views[v])
+                        {
+                            const float distance = p.nx * s.cx[i] + p.ny * s.cy[i] + p.nz * s.cz[i] - p.distance;
+                            const float radius = p.ax * s.ex[i] + p.ay * s.ey[i] + p.az * s.ez[i];
+                            inside &= distance + radius >= 0.0f;
+                        }
+                        mask |= static_cast<ViewMask>(inside) << v;
+                    }
+                    masks[i] = mask;
+                }
+            }
+
+#if VOSGI_SIMD_X86
+            // A plane broadcast to every lane once per call, so the box loop reads it as memory operands
+            // instead of broadcasting 42 constants per view for every block of boxes
+            struct SplatPlaneSSE2
+            {
+                __m128 nx, ny, nz;
+                __m128 ax, ay, az;
+                __m128 distance;
+            };
+
+            struct SplatPlaneAVX2
+            {
+                __m256 nx, ny, nz;
+                __m256 ax, ay, az;
+                __m256 distance;
+            };
+
+            void MultiCullSSE2(const PackedPlane (*views)[6], size_t viewCount, const Streams& s, size_t count, ViewMask* masks)
+            {
+                const __m128 zero = _mm_setzero_ps();
+
+                SplatPlaneSSE2 planes[MaxViews][6];
+                __m128i bits[MaxViews];
+                for (size_t v = 0; v < viewCount; ++v)
+                {
+                    for (int k = 0; k < 6; ++k)
+                    {
+                        const PackedPlane& p = views[v][k];
+                        planes[v][k] = {_mm_set1_ps(p.nx), _mm_set1_ps(p.ny), _mm_set1_ps(p.nz),
+                                        _mm_set1_ps(p.ax), _mm_set1_ps(p.ay), _mm_set1_ps(p.az), _mm_set1_ps(p.distance)};
+                    }
+                    bits[v] = _mm_set1_epi32(static_cast<int>(ViewMask(1) << v));
+                }
+
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    const __m128 cx = _mm_loadu_ps(s.cx + i), cy = _mm_loadu_ps(s.cy + i), cz = _mm_loadu_ps(s.cz + i);
+                    const __m128 ex = _mm_loadu_ps(s.ex + i), ey = _mm_loadu_ps(s.ey + i), ez = _mm_loadu_ps(s.ez + i);
+
+                    // The view bits of the four boxes build up in the lanes, stored once at the end
+                    __m128i mask = _mm_setzero_si128();
+                    for (size_t v = 0; v < viewCount; ++v)
+                    {
+                        __m128 inside = _mm_cmpeq_ps(zero, zero);
+                        for (const auto& p : planes[v])
+                        {
+                            __m128 sum = _mm_sub_ps(_mm_mul_ps(p.nx, cx), p.distance);
+                            sum = _mm_add_ps(sum, _mm_mul_ps(p.ny, cy));
+                            sum = _mm_add_ps(sum, _mm_mul_ps(p.nz, cz));
+                            sum = _mm_add_ps(sum, _mm_mul_ps(p.ax, ex));
+                            sum = _mm_add_ps(sum, _mm_mul_ps(p.ay, ey));
+                            sum = _mm_add_ps(sum, _mm_mul_ps(p.az, ez));
+                            inside = _mm_and_ps(inside, _mm_cmpge_ps(sum, zero));
+                        }
+                        mask = _mm_or_si128(mask, _mm_and_si128(_mm_castps_si128(inside), bits[v]));
+                    }
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(masks + i), mask);
+                }
+
+                MultiCullScalar(views, viewCount, s, i, count, masks);
+            }
+
+            VOSGI_TARGET_AVX2 void MultiCullAVX2(const PackedPlane (*views)[6], size_t viewCount, const Streams& s, size_t count, ViewMask* masks)
+            {
+                const __m256 zero = _mm256_setzero_ps();
+
+                SplatPlaneAVX2 planes[MaxViews][6];
+                __m256i bits[MaxViews];
+                for (size_t v = 0; v < viewCount; ++v)
+                {
+                    for (int k = 0; k < 6; ++k)
+                    {
+                        const PackedPlane& p = views[v][k];
+                        planes[v][k] = {_mm256_set1_ps(p.nx), _mm256_set1_ps(p.ny), _mm256_set1_ps(p.nz),
+                                        _mm256_set1_ps(p.ax), _mm256_set1_ps(p.ay), _mm256_set1_ps(p.az), _mm256_set1_ps(p.distance)};
+                    }
+                    bits[v] = _mm256_set1_epi32(static_cast<int>(ViewMask(1) << v));
+                }
+
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8)
+                {
+                    const __m256 cx = _mm256_loadu_ps(s.cx + i), cy = _mm256_loadu_ps(s.cy + i), cz = _mm256_loadu_ps(s.cz + i);
+                    const __m256 ex = _mm256_loadu_ps(s.ex + i), ey = _mm256_loadu_ps(s.ey + i), ez = _mm256_loadu_ps(s.ez + i);
+
+                    __m256i mask = _mm256_setzero_si256();
+                    for (size_t v = 0; v < viewCount; ++v)
+                    {
+                        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                        for (const auto& p : planes[v])
+                        {
+                            __m256 sum = _mm256_fmsub_ps(p.nx, cx, p.distance);
+                            sum = _mm256_fmadd_ps(p.ny, cy, sum);
+                            sum = _mm256_fmadd_ps(p.nz, cz, sum);
+                            sum = _mm256_fmadd_ps(p.ax, ex, sum);
+                            sum = _mm256_fmadd_ps(p.ay, ey, sum);
+                            sum = _mm256_fmadd_ps(p.az, ez, sum);
+                            inside = _mm256_and_ps(inside, _mm256_cmp_ps(sum, zero, _CMP_GE_OQ));
+                        }
+                        mask = _mm256_or_si256(mask, _mm256_and_si256(_mm256_castps_si256(inside), bits[v]));
+                    }
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(masks + i), mask);
+                }
+
+                MultiCullScalar(views, viewCount, s, i, count, masks);
+            }
+#endif
+
+            // Proportional to the views seeing each object, for the tails and when SIMD is off
+            void SplitViewsScalar(const ViewMask* views, size_t count, size_t viewCount, uint32_t* words)
+            {
+                std::fill(words, words + viewCount, 0u);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    for (ViewMask bits = views[i]; bits != 0; bits &= bits - 1)
+                    {
+                        words[std::countr_zero(bits)] |= 1u << i;
+                    }
+                }
+            }
+
+#if VOSGI_SIMD_X86
+            // Moves bit v of every mask to the sign bit, where movemask collects one bit per object
+            void SplitViewsSSE2(const ViewMask* views, size_t viewCount, uint32_t* words)
+            {
+                __m128i masks[8];
+                for (int k = 0; k < 8; ++k) masks[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(views) + k);
+
+                for (size_t v = 0; v < viewCount; ++v)
+                {
+                    const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(31 - v));
+                    uint32_t word = 0;
+                    for (int k = 0; k < 8; ++k)
+                    {
+                        word |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_sll_epi32(masks[k], shift)))) << (4 * k);
+                    }
+                    words[v] = word;
+                }
+            }
+
+            VOSGI_TARGET_AVX2 void SplitViewsAVX2(const ViewMask* views, size_t viewCount, uint32_t* words)
+            {
+                __m256i masks[4];
+                for (int k = 0; k < 4; ++k) masks[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(views) + k);
+
+                for (size_t v = 0; v < viewCount; ++v)
+                {
+                    const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(31 - v));
+                    uint32_t word = 0;
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        word |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_sll_epi32(masks[k], shift)))) << (8 * k);
+                    }
+                    words[v] = word;
+                }
+            }
+#endif
+        }
+
+        size_t FrustumCull(const Frustum& frustum, const BoundsArrays& bounds, VisibilityMask& visibility)
+        {
+            PackedPlane planes[6];
+            PackPlanes(frustum, planes);
+
+            const size_t count = bounds.Size();
+            visibility.assign((count + 31) / 32, 0u);
+
+            const Streams streams = GetStreams(bounds);
+
+            switch (SIMD::GetLevel())
+            {
+#if VOSGI_SIMD_X86
+            case SIMD::Level::AVX2:
+                CullAVX2(planes, streams, count, visibility.data());
+                break;
+            case SIMD::Level::SSE2:
+                CullSSE2(planes, streams, count, visibility.data());
+                break;
+#endif
+            default:
+                CullScalar(planes, streams, 0, count, visibility.data());
+                break;
+            }
+
+            size_t visible = 0;
+            for (uint32_t word : visibility)
+            {
+                visible += static_cast<size_t>(std::popcount(word));
+            }
+            return visible;
+        }
+
+        size_t MultiFrustumCull(const Frustum* frustums, size_t viewCount, const BoundsArrays& bounds, std::vector<ViewMask>& views)
+        {
+            viewCount = std::min(viewCount, MaxViews);
+
+            PackedPlane planes[MaxViews][6];
+            for (size_t v = 0; v < viewCount; ++v)
+            {
+                PackPlanes(frustums[v], planes[v]);
+            }
+
+            const size_t count = bounds.Size();
+            views.resize(count);
+
+            const Streams streams = GetStreams(bounds);
+            switch (SIMD::GetLevel())
+            {
+#if VOSGI_SIMD_X86
+            case SIMD::Level::AVX2:
+                MultiCullAVX2(planes, viewCount, streams, count, views.data());
+                break;
+            case SIMD::Level::SSE2:
+                MultiCullSSE2(planes, viewCount, streams, count, views.data());
+                break;
+#endif
+            default:
+                MultiCullScalar(planes, viewCount, streams, 0, count, views.data());
+                break;
+            }
+
+            return static_cast<size_t>(std::count_if(views.begin(), views.end(), [](ViewMask mask) { return mask != 0; }));
+        }
+
+        void SplitViews(const ViewMask* views, size_t count, size_t viewCount, uint32_t* words)
+        {
+            viewCount = std::min(viewCount, MaxViews);
+            if (count < 32)
+            {
+                SplitViewsScalar(views, count, viewCount, words);
+                return;
+            }
+
+            switch (SIMD::GetLevel())
+            {
+#if VOSGI_SIMD_X86
+            case SIMD::Level::AVX2:
+                SplitViewsAVX2(views, viewCount, words);
+                break;
+            case SIMD::Level::SSE2:
+                SplitViewsSSE2(views, viewCount, words);
+                break;
+#endif
+            default:
+                SplitViewsScalar(views, 32, viewCount, words);
+                break;
+            }
+        }
+    } // namespace Culling
+} // namespace Vosgi
@@ -26,6 +26,7 @@ namespace Vosgi
         window->Initialize();
         window->SetMouseEnabled(false);
         window->Run();
+        window->Terminate();
     }
 
     void Editor::DrawMenuBar()
@@ -49,7 +50,7 @@ namespace Vosgi
                 ImGui::Separator();
                 if (ImGui::MenuItem("Exit"))
                 {
-                    window->Terminate();
+                    window->Close();
                 }
                 ImGui::EndMenu();
             }
@@ -28,6 +28,6 @@ namespace Vosgi
     {
         Game *game = new Game();
         game->Run();
-        //delete game;
+        delete game;
     }
 } // namespace Vosgi
@@ -3,82 +3,158 @@
 namespace Vosgi
 {
 
-    Entity::Entity()
+    Entity* Entity::Create(std::string_view name, std::string_view tag)
     {
-        name = std::string("New Entity");
-        tag = std::string("Untagged");
-
-        AssignEvents();
+        return EntityPool::Instance().Create(name, tag);
     }
 
-    Entity::Entity(std::string name, std::string tag)
-        : name(name), tag(tag)
+    Entity::Entity()
     {
+        transform.m_entity = this;
         AssignEvents();
     }
 
     Entity::~Entity()
     {
-        for (auto &behaviour : behaviours)
+        Release();
+    }
+
+    void Entity::Release()
+    {
+        for (auto *behaviour : behaviours)
         {
             behaviour->Terminate();
+            ComponentPoolBase::Release(behaviour);
         }
+
+        // Keep the capacity around for the next entity using this slot
         behaviours.clear();
+        std::fill(behavioursByType.begin(), behavioursByType.end(), nullptr);
 
-        for (auto &child : children)
-        {
-            child->~Entity();
-        }
-        children.clear();
-    }
+        transform.position = glm::vec3(0.0f);
+        transform.rotation = Quaternion();
+        transform.localScale = glm::vec3(1.0f);
+        transform.SetDirty();
 
-    void Entity::AddChild(std::unique_ptr<Entity> child)
-    {
-        child->parent = this;
-        children.push_back(std::move(child));
+        hasSubtreeBounds = false;
+        subtreeDirty = true;
+        enabled = true;
     }
 
-    void Entity::RemoveChild(Entity *child)
+    void Entity::UpdateBounds()
     {
-        children.remove_if([child](std::unique_ptr<Entity> &c)
-                           { return c.get() == child; });
+        InvalidateSubtreeBounds();
+        if (spatialEntry == LooseOctree::NullEntry) return;
+
+        if (Model *model = GetExactBehaviour<Model>())
+        {
+            LooseOctree::Main().Update(spatialEntry, model->UpdateBounds());
+            return;
+        }
+        LooseOctree::Main().Update(spatialEntry, GetWorldBounds());
     }
 
-    void Entity::RemoveChild(size_t index)
+    AABB Entity::GetWorldBounds() const
     {
-        auto it = children.begin();
-        std::advance(it, index);
-        children.erase(it);
+        if (Model *model = GetExactBehaviour<Model>()) return model->GetWorldAABB();
+        return AABB(transform.GetModel().GetTranslation(), 0.0f, 0.0f, 0.0f);
     }
 
-    void Entity::UpdateSelfAndChildren()
+    void Entity::RefitSubtreeBounds()
     {
-        if (transform.IsDirty())
+        if (!subtreeDirty) return;
+        subtreeDirty = false;
+
+        hasSubtreeBounds = false;
+        auto merge = [this](const glm::vec3 &min, const glm::vec3 &max) {
+            subtreeMin = hasSubtreeBounds ? glm::min(subtreeMin, min) : min;
+            subtreeMax = hasSubtreeBounds ? glm::max(subtreeMax, max) : max;
+            hasSubtreeBounds = true;
+        };
+
+        Model *model = GetExactBehaviour<Model>();
+        if (model && model->IsActive())
         {
-            ForceUpdateSelfAndChildren();
+            const AABB bounds = model->GetWorldAABB();
+            merge(bounds.center - bounds.extents, bounds.center + bounds.extents);
         }
 
-        for (auto &child : children)
+        // Clean children keep their bounds, only the changed branches are walked
+        for (Entity *child = GetFirstChild(); child; child = child->GetNextSibling())
         {
-            child->UpdateSelfAndChildren();
+            child->RefitSubtreeBounds();
+            if (child->hasSubtreeBounds) merge(child->subtreeMin, child->subtreeMax);
         }
     }
 
-    void Entity::ForceUpdateSelfAndChildren()
+    void Entity::InvalidateSubtreeBounds()
     {
-        if (parent != nullptr)
+        subtreeDirty = true;
+
+        // A dirty ancestor already has its own ancestors marked
+        for (Entity *ancestor = GetParent(); ancestor && !ancestor->subtreeDirty; ancestor = ancestor->GetParent())
         {
-            transform.ComputeModelMatrix(parent->transform.GetModel());
+            ancestor->subtreeDirty = true;
         }
-        else
+    }
+
+    bool Entity::GetSubtreeBounds(AABB &bounds) const
+    {
+        if (!hasSubtreeBounds) return false;
+        bounds = AABB(subtreeMin, subtreeMax);
+        return true;
+    }
+
+    void Entity::AddChild(Entity *child)
+    {
+        EntityPool::Instance().SetParent(*child, this);
+    }
+
+    void Entity::RemoveChild(Entity *child)
+    {
+        if (child->GetParent() != this) return;
+        child->Destroy();
+    }
+
+    void Entity::RemoveChild(size_t index)
+    {
+        Entity *child = GetFirstChild();
+        for (; child && index > 0; --index)
         {
-            transform.ComputeModelMatrix();
+            child = child->GetNextSibling();
         }
 
-        for (auto &child : children)
+        if (child) child->Destroy();
+    }
+
+    void Entity::Destroy()
+    {
+        EntityPool::Instance().Destroy(handle);
+    }
+
+    Entity *Entity::GetParent() const
+    {
+        return EntityPool::Instance().Get(parent);
+    }
+
+    Entity *Entity::GetFirstChild() const
+    {
+        return EntityPool::Instance().Get(firstChild);
+    }
+
+    Entity *Entity::GetNextSibling() const
+    {
+        return EntityPool::Instance().Get(nextSibling);
+    }
+
+    size_t Entity::GetChildCount() const
+    {
+        size_t count = 0;
+        for (Entity *child = GetFirstChild(); child; child = child->GetNextSibling())
         {
-            child->ForceUpdateSelfAndChildren();
+            ++count;
         }
+        return count;
     }
 
     void Entity::SetEnabled(bool value)
@@ -92,38 +168,15 @@ namespace Vosgi
         }
 
         // Propagate to children
-        for (auto &child : children)
+        for (Entity *child = GetFirstChild(); child; child = child->GetNextSibling())
         {
             child->SetEnabled(value);
         }
     }
 
-    void Entity::DrawSelfAndChildren(float deltaTime, const Frustum &frustum, Shader &shader, unsigned int &display, unsigned int &draw, unsigned int &total)
-    {
-        if (!enabled) return;
-
-        UpdateSelfAndChildren();
-
-        for (auto &component : behaviours)
-        {
-            if (!component->IsActive()) continue;
-
-            component->Update(deltaTime);
-            // ...
-            component->LateUpdate(deltaTime);
-            component->Draw(frustum, shader, display, draw);
-        }
-        total++;
-
-        for (auto &child : children)
-        {
-            child->DrawSelfAndChildren(deltaTime, frustum, shader, display, draw, total);
-        }
-    }
-
     void Entity::DrawInspector()
     {
-        ImGui::PushID((void*)GUID.c_str());
+        ImGui::PushID((void*)this);
 
         bool isEnabled = enabled;
         if (ImGui::Checkbox(("##" + name).c_str(), &isEnabled)) {
@@ -136,12 +189,14 @@ namespace Vosgi
         }
 
         // ImGui::SameLine();
-        ImGui::Text("Tag: %s", tag.c_str());
-        ImGui::Text("GUID: %s", GetGUID().c_str());
+        ImGui::Text("Tag: %s", tag.GetString());
+        ImGui::Text("GUID: %s", guid.ToString().c_str());
         ImGui::Separator();
 
         // Transform
-        ImGui::SliderFloat3("Position", (float*)&transform.position, -100.0f, 100.0f);
+        if (ImGui::SliderFloat3("Position", (float*)&transform.position, -100.0f, 100.0f)) {
+            transform.SetDirty();
+        }
 
         // Retrieve the Euler angles in degrees
         glm::vec3 eulerDegrees = transform.rotation.GetEulerAnglesDegrees();
@@ -152,12 +207,13 @@ namespace Vosgi
             transform.SetDirty();
         }
 
-        ImGui::SliderFloat3("Scale", (float*)&transform.localScale, 0.0f, 100.0f);
-        transform.SetDirty();
+        if (ImGui::SliderFloat3("Scale", (float*)&transform.localScale, 0.0f, 100.0f)) {
+            transform.SetDirty();
+        }
 
         ImGui::Separator();
-        for (auto& behaviour : behaviours) {
-            ImGui::PushID((void*)behaviour.get());
+        for (auto* behaviour : behaviours) {
+            ImGui::PushID((void*)behaviour);
 
             // Get the type name of the behaviour
             std::string typeName = typeid(*behaviour).name();
@@ -173,10 +229,8 @@ namespace Vosgi
             }
             ImGui::SameLine();
             if (ImGui::CollapsingHeader(typeName.c_str())) {
-                ImGui::PushID((void*)behaviour->GetGUID().c_str());
-                ImGui::Text("GUID: %s", behaviour->GetGUID().c_str());
+                ImGui::Text("GUID: %s", behaviour->GetGUID().ToString().c_str());
                 behaviour->DrawInspector();
-                ImGui::PopID();
             }
 
             ImGui::PopID();
@@ -185,12 +239,12 @@ namespace Vosgi
         }
 
         // Children
-        if (!children.empty())
+        if (firstChild.IsValid())
         {
-            ImGui::Text("Children: %d", static_cast<int>(children.size()));
+            ImGui::Text("Children: %d", static_cast<int>(GetChildCount()));
             ImGui::Indent();
-            for (auto &child: children) {
-                ImGui::PushID((void *) child.get());
+            for (Entity *child = GetFirstChild(); child; child = child->GetNextSibling()) {
+                ImGui::PushID((void *) child);
                 child->DrawInspector();
                 ImGui::PopID();
             }
@@ -206,4 +260,28 @@ namespace Vosgi
         enabled.Subscribe(MakeMethodPointer(this, &Entity::SetEnabled));
     }
 
+    void Entity::IndexBehaviour(Behaviour *behaviour)
+    {
+        const ComponentTypeId type = behaviour->GetComponentType();
+        if (behavioursByType.size() <= type)
+        {
+            behavioursByType.resize(type + 1, nullptr);
+        }
+
+        // Keep the first behaviour of each type, like GetBehaviour always did
+        if (!behavioursByType[type])
+        {
+            behavioursByType[type] = behaviour;
+        }
+    }
+
+    void Entity::RebuildBehaviourIndex()
+    {
+        std::fill(behavioursByType.begin(), behavioursByType.end(), nullptr);
+        for (auto *behaviour : behaviours)
+        {
+            IndexBehaviour(behaviour);
+        }
+    }
+
 }
\ No newline at end of file
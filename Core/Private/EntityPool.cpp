@@ -0,0 +1,324 @@
+#include "../Public/EntityPool.h"
+
+#include <cassert>
+#include <cstdio>
+#include <new>
+
+#include "../Public/AABBTree.h"
+#include "../Public/Entity.h"
+#include "../Public/GUIDRegistry.h"
+
+namespace Vosgi
+{
+    struct EntityPool::Chunk
+    {
+        alignas(Entity) unsigned char storage[sizeof(Entity) * ChunkSize];
+    };
+
+    EntityPool& EntityPool::Instance()
+    {
+        static EntityPool pool;
+        return pool;
+    }
+
+    EntityPool::EntityPool()
+    {
+        // Construct the singletons entities release into first, so they are destroyed after the pool
+        TransformHierarchy::Main();
+        LooseOctree::Main();
+        AABBTree::Main();
+    }
+
+    EntityPool::~EntityPool()
+    {
+        // Only reached at exit with entities still alive when the game did not destroy them,
+        // the component pools destroyed before this one release them through DestroyAll too
+        DestroyAll();
+        FlushDestroyed();
+
+        // Released slots stay constructed for reuse
+        for (uint32_t index = 0; index < slotCount; ++index)
+        {
+            Slot(index)->~Entity();
+        }
+    }
+
+    Entity* EntityPool::Slot(uint32_t index) const
+    {
+        return reinterpret_cast<Entity*>(chunks[index / ChunkSize]->storage + sizeof(Entity) * (index % ChunkSize));
+    }
+
+    Entity* EntityPool::Create(std::string_view name, std::string_view tag)
+    {
+        uint32_t index;
+        Entity* entity;
+
+        if (!freeSlots.empty())
+        {
+            // Reuse a released entity, it is still constructed
+            index = freeSlots.back();
+            freeSlots.pop_back();
+
+            entity = Slot(index);
+        }
+        else
+        {
+            // The index must fit in the handle, refuse the entity rather than alias another one
+            assert(slotCount <= EntityHandle::MaxIndex && "EntityPool is full");
+            if (slotCount > EntityHandle::MaxIndex)
+            {
+                printf("ERROR::ENTITY_POOL_FULL: %u entities\n", slotCount);
+                return nullptr;
+            }
+
+            index = slotCount++;
+            if (index / ChunkSize >= chunks.size())
+            {
+                chunks.push_back(std::make_unique<Chunk>());
+            }
+            generations.push_back(1);
+
+            entity = new (Slot(index)) Entity();
+        }
+
+        entity->handle = EntityHandle(index, generations[index]);
+        entity->guid = GUID::Generate();
+        GUIDRegistry::Register(entity->guid, entity->handle);
+        entity->pendingDestroy = false;
+        entity->liveIndex = static_cast<uint32_t>(live.size());
+        live.push_back(entity);
+
+        // The slot keeps the capacity of its previous name
+        entity->name.assign(name);
+        entity->nameId = StringId(name);
+        entity->nameSlot = Insert(names, entity->nameId, entity);
+        entity->tag = StringId::Intern(tag);
+        entity->tagSlot = Insert(tags, entity->tag, entity);
+
+        entity->spatialEntry = LooseOctree::Main().Insert(entity->handle, entity->GetWorldBounds());
+
+        Link(*entity, nullptr);
+        return entity;
+    }
+
+    Entity* EntityPool::Get(EntityHandle handle) const
+    {
+        const uint32_t index = handle.GetIndex();
+        if (!handle.IsValid() || index >= slotCount) return nullptr;
+        if (generations[index] != handle.GetGeneration()) return nullptr;
+        return Slot(index);
+    }
+
+    void EntityPool::Destroy(EntityHandle handle)
+    {
+        Entity* entity = Get(handle);
+        if (!entity || entity->pendingDestroy) return;
+
+        entity->pendingDestroy = true;
+        pendingDestroy.push_back(handle);
+    }
+
+    void EntityPool::FlushDestroyed()
+    {
+        // Handles already destroyed with their parent no longer resolve
+        for (auto handle : pendingDestroy)
+        {
+            if (Entity* entity = Get(handle))
+            {
+                DestroyImmediate(*entity);
+            }
+        }
+        pendingDestroy.clear();
+    }
+
+    void EntityPool::DestroyAll()
+    {
+        for (Entity* root = GetFirstRoot(); root; root = Get(root->nextSibling))
+        {
+            Destroy(root->handle);
+        }
+    }
+
+    Entity* EntityPool::FindByName(StringId name) const
+    {
+        const auto* bucket = names.Find(name);
+        return bucket && !bucket->empty() ? bucket->front() : nullptr;
+    }
+
+    Entity* EntityPool::FindByTag(StringId tag) const
+    {
+        const auto* bucket = tags.Find(tag);
+        return bucket && !bucket->empty() ? bucket->front() : nullptr;
+    }
+
+    const std::vector<Entity*>& EntityPool::FindAllByTag(StringId tag) const
+    {
+        static const std::vector<Entity*> none;
+
+        const auto* bucket = tags.Find(tag);
+        return bucket ? *bucket : none;
+    }
+
+    void EntityPool::SetName(Entity& entity, std::string_view name)
+    {
+        if (Entity* moved = Erase(names, entity.nameId, entity.nameSlot)) moved->nameSlot = entity.nameSlot;
+
+        entity.name.assign(name);
+        entity.nameId = StringId(name);
+        entity.nameSlot = Insert(names, entity.nameId, &entity);
+    }
+
+    void EntityPool::SetTag(Entity& entity, std::string_view tag)
+    {
+        if (Entity* moved = Erase(tags, entity.tag, entity.tagSlot)) moved->tagSlot = entity.tagSlot;
+
+        entity.tag = StringId::Intern(tag);
+        entity.tagSlot = Insert(tags, entity.tag, &entity);
+    }
+
+    EntityPool::Index::Index(size_t capacity) : slots(capacity, 0) {}
+
+    size_t EntityPool::Index::Probe(StringId key) const
+    {
+        // The slot holding the key, or the empty slot where it would go
+        const size_t mask = slots.size() - 1;
+        size_t slot = static_cast<size_t>(key.hash) & mask;
+        while (slots[slot] != 0 && buckets[slots[slot] - 1].first != key)
+        {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    const std::vector<Entity*>* EntityPool::Index::Find(StringId key) const
+    {
+        const uint32_t bucket = slots[Probe(key)];
+        return bucket != 0 ? &buckets[bucket - 1].second : nullptr;
+    }
+
+    std::vector<Entity*>& EntityPool::Index::Get(StringId key)
+    {
+        size_t slot = Probe(key);
+        if (slots[slot] != 0) return buckets[slots[slot] - 1].second;
+
+        // Keep the table at most half full, rehashing only the slots
+        if ((buckets.size() + 1) * 2 > slots.size())
+        {
+            slots.assign(slots.size() * 2, 0);
+            for (uint32_t bucket = 0; bucket < buckets.size(); ++bucket)
+            {
+                slots[Probe(buckets[bucket].first)] = bucket + 1;
+            }
+            slot = Probe(key);
+        }
+
+        buckets.emplace_back(key, std::vector<Entity*>());
+        slots[slot] = static_cast<uint32_t>(buckets.size());
+        return buckets.back().second;
+    }
+
+    uint32_t EntityPool::Insert(Index& index, StringId key, Entity* entity)
+    {
+        auto& bucket = index.Get(key);
+        bucket.push_back(entity);
+        return static_cast<uint32_t>(bucket.size() - 1);
+    }
+
+    Entity* EntityPool::Erase(Index& index, StringId key, uint32_t position)
+    {
+        // Empty buckets are kept, tags are reused and FindAllByTag hands out references
+        auto& bucket = index.Get(key);
+        Entity* last = bucket.back();
+        bucket[position] = last;
+        bucket.pop_back();
+        return position < bucket.size() ? last : nullptr;
+    }
+
+    void EntityPool::SetParent(Entity& child, Entity* parent)
+    {
+        // Refuse to create a cycle
+        for (Entity* ancestor = parent; ancestor; ancestor = Get(ancestor->parent))
+        {
+            if (ancestor == &child) return;
+        }
+
+        Unlink(child);
+        Link(child, parent);
+    }
+
+    void EntityPool::Link(Entity& entity, Entity* parent)
+    {
+        EntityHandle& first = parent ? parent->firstChild : firstRoot;
+        EntityHandle& last = parent ? parent->lastChild : lastRoot;
+
+        entity.parent = parent ? parent->handle : EntityHandle();
+        entity.prevSibling = last;
+        entity.nextSibling = EntityHandle();
+
+        if (Entity* previous = Get(last))
+            previous->nextSibling = entity.handle;
+        else
+            first = entity.handle;
+        last = entity.handle;
+
+        entity.transform.SetParent(parent ? &parent->transform : nullptr);
+        entity.InvalidateSubtreeBounds();
+    }
+
+    void EntityPool::Unlink(Entity& entity)
+    {
+        Entity* parent = Get(entity.parent);
+        if (parent) parent->InvalidateSubtreeBounds();
+
+        EntityHandle& first = parent ? parent->firstChild : firstRoot;
+        EntityHandle& last = parent ? parent->lastChild : lastRoot;
+
+        if (Entity* previous = Get(entity.prevSibling))
+            previous->nextSibling = entity.nextSibling;
+        else
+            first = entity.nextSibling;
+
+        if (Entity* next = Get(entity.nextSibling))
+            next->prevSibling = entity.prevSibling;
+        else
+            last = entity.prevSibling;
+
+        entity.parent = EntityHandle();
+        entity.prevSibling = EntityHandle();
+        entity.nextSibling = EntityHandle();
+    }
+
+    void EntityPool::DestroyImmediate(Entity& entity)
+    {
+        while (Entity* child = Get(entity.firstChild))
+        {
+            DestroyImmediate(*child);
+        }
+
+        Unlink(entity);
+        entity.transform.SetParent(nullptr);
+        entity.Release();
+
+        // Invalidate every outstanding handle, skipping 0 so a handle is never null
+        const uint32_t index = entity.handle.GetIndex();
+        uint32_t generation = (generations[index] + 1) & EntityHandle::GenerationMask;
+        generations[index] = generation == 0 ? 1 : generation;
+
+        Entity* last = live.back();
+        live[entity.liveIndex] = last;
+        last->liveIndex = entity.liveIndex;
+        live.pop_back();
+
+        if (Entity* moved = Erase(names, entity.nameId, entity.nameSlot)) moved->nameSlot = entity.nameSlot;
+        if (Entity* moved = Erase(tags, entity.tag, entity.tagSlot)) moved->tagSlot = entity.tagSlot;
+
+        LooseOctree::Main().Remove(entity.spatialEntry);
+        entity.spatialEntry = LooseOctree::NullEntry;
+
+        GUIDRegistry::Unregister(entity.guid);
+        entity.guid = GUID();
+        entity.handle = EntityHandle();
+        entity.pendingDestroy = false;
+        freeSlots.push_back(index);
+    }
+} // namespace Vosgi
@@ -0,0 +1,79 @@
+#include "../Public/GUIDRegistry.h"
+
+namespace Vosgi
+{
+    std::vector<GUIDRegistry::Slot> GUIDRegistry::slots = std::vector<GUIDRegistry::Slot>(8192);
+    size_t GUIDRegistry::count = 0;
+
+    size_t GUIDRegistry::Probe(const GUID& guid)
+    {
+        // GUIDs are random, their bits are hash enough
+        const size_t mask = slots.size() - 1;
+        size_t slot = static_cast<size_t>(guid.hi ^ guid.lo) & mask;
+        while (slots[slot].guid.IsValid() && slots[slot].guid != guid)
+        {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void GUIDRegistry::Insert(const Slot& entry)
+    {
+        // Keep the table at most half full so probes stay short
+        if ((count + 1) * 2 > slots.size())
+        {
+            std::vector<Slot> previous(slots.size() * 2);
+            previous.swap(slots);
+            for (const Slot& moved : previous)
+            {
+                if (moved.guid.IsValid()) slots[Probe(moved.guid)] = moved;
+            }
+        }
+
+        Slot& slot = slots[Probe(entry.guid)];
+        if (!slot.guid.IsValid()) ++count;
+        slot = entry;
+    }
+
+    void GUIDRegistry::Register(const GUID& guid, EntityHandle entity)
+    {
+        Insert({guid, entity, nullptr});
+    }
+
+    void GUIDRegistry::Register(const GUID& guid, Behaviour* behaviour)
+    {
+        Insert({guid, EntityHandle(), behaviour});
+    }
+
+    void GUIDRegistry::Unregister(const GUID& guid)
+    {
+        size_t hole = Probe(guid);
+        if (!slots[hole].guid.IsValid()) return;
+        --count;
+
+        // Shift back the following entries that would no longer be reachable across the hole
+        const size_t mask = slots.size() - 1;
+        for (size_t next = (hole + 1) & mask; slots[next].guid.IsValid(); next = (next + 1) & mask)
+        {
+            const size_t home = static_cast<size_t>(slots[next].guid.hi ^ slots[next].guid.lo) & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                slots[hole] = slots[next];
+                hole = next;
+            }
+        }
+        slots[hole] = Slot();
+    }
+
+    Entity* GUIDRegistry::FindEntity(const GUID& guid)
+    {
+        // Behaviours hold an invalid handle, which never resolves
+        const Slot& slot = slots[Probe(guid)];
+        return slot.guid.IsValid() ? EntityPool::Instance().Get(slot.entity) : nullptr;
+    }
+
+    Behaviour* GUIDRegistry::FindBehaviour(const GUID& guid)
+    {
+        return slots[Probe(guid)].behaviour;
+    }
+} // namespace Vosgi
@@ -19,71 +19,68 @@ namespace Vosgi
         shinyMaterial = Material(0.5f, 32.0f);
 
         // Create objects
-        Entity *mainLightEntity = new Entity("Main Light", "Light");
+        Entity *mainLightEntity = Entity::Create("Main Light", "Light");
         mainLightEntity->AddBehaviour<DirectionalLight>(.5f, .5f, .5f, 1.0f, 1.0f);
         mainLightEntity->transform.SetRotation(glm::quat(glm::radians(glm::vec3(45.0f, 45.0f, 0.0f))));
 
         // point light
-        Entity *pointLightEntity = new Entity("Point Light", "Light");
+        Entity *pointLightEntity = Entity::Create("Point Light", "Light");
         PointLight *pointLight = pointLightEntity->AddBehaviour<PointLight>(1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.1f, 0.1f, 0.1f);
         pointLight->color = glm::vec3(0.0f, 0.0f, 1.0f);
         pointLightEntity->transform.SetPosition(glm::vec3(-10.0f, 0.0f, 0.0f));
 
         // second point light
-        Entity *pointLightEntity2 = new Entity("Point Light 2", "Light");
+        Entity *pointLightEntity2 = Entity::Create("Point Light 2", "Light");
         PointLight *pointLight2 = pointLightEntity2->AddBehaviour<PointLight>(1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.1f, 0.1f, 0.1f);
         pointLight2->color = glm::vec3(0.0f, 1.0f, 0.0f);
         pointLightEntity2->transform.SetPosition(glm::vec3(0.0f, 0.0f, -10.0f));
 
         // third point light
-        Entity *pointLightEntity3 = new Entity("Point Light 3", "Light");
+        Entity *pointLightEntity3 = Entity::Create("Point Light 3", "Light");
         PointLight *pointLight3 = pointLightEntity3->AddBehaviour<PointLight>(1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.1f, 0.1f, 0.1f);
         pointLight3->color = glm::vec3(1.0f, 0.0f, 0.0f);
         pointLightEntity3->transform.SetPosition(glm::vec3(10.0f, 0.0f, 0.0f));
 
         // point light parent
-        Entity *pointLightParent = new Entity("Point Light Parent", "Light");
-        pointLightParent->AddChild(std::unique_ptr<Entity>(pointLightEntity));
-        pointLightParent->AddChild(std::unique_ptr<Entity>(pointLightEntity2));
-        pointLightParent->AddChild(std::unique_ptr<Entity>(pointLightEntity3));
+        Entity *pointLightParent = Entity::Create("Point Light Parent", "Light");
+        pointLightParent->AddChild(pointLightEntity);
+        pointLightParent->AddChild(pointLightEntity2);
+        pointLightParent->AddChild(pointLightEntity3);
         pointLightParent->AddBehaviour<Rotating>();
 
         // spot light
-        Entity *spotLightEntity = new Entity("Spot Light", "Light");
+        Entity *spotLightEntity = Entity::Create("Spot Light", "Light");
         spotLightEntity->AddBehaviour<SpotLight>(1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.1f, 0.1f, 0.1f, 35.0f);
         spotLightEntity->transform.SetPosition(glm::vec3(0.0f, 0.0f, 15.0f));
         spotLightEntity->transform.SetRotation(glm::quat(glm::radians(glm::vec3(0.0f, 180.0f, 0.0f))));
 
-        Entity *cameraEntity = new Entity("Main Camera", "MainCamera");
-        camera = cameraEntity->AddBehaviour<Camera>(glm::vec3(0.0f, 0.0f, 10.0f), 45, window->GetAspectRatio(), 0.1f, 1000.0f);
+        Entity *cameraEntity = Entity::Create("Main Camera", "MainCamera");
+        cameraEntity->AddBehaviour<Camera>(glm::vec3(0.0f, 0.0f, 10.0f), 45, window->GetAspectRatio(), 0.1f, 1000.0f);
 
         // Floor
-        Entity *floorEntity = new Entity("Floor", "Untagged");
-        floorEntity->AddBehaviour<Model>("Assets/Models/Floor/Floor.obj");
+        Entity *floorEntity = Entity::Create("Floor", "Untagged");
+        floorEntity->AddBehaviour<Model>("Assets/Models/Floor/Floor.obj")->SetOccluder(true);
         floorEntity->transform.SetPosition(glm::vec3(0.0f, -23.0f, 0.0f));
         floorEntity->transform.SetLocalScale(glm::vec3(10.0f, 10.0f, 10.0f));
 
         // Flower
-        Entity *flowerEntity = new Entity("Calvin And Hobbes by npbehunin", "Untagged");
+        Entity *flowerEntity = Entity::Create("Calvin And Hobbes by npbehunin", "Untagged");
         flowerEntity->AddBehaviour<Model>("Assets/Models/calvinhobbes/scene.gltf");
 
         // Lantern
-        Entity *lanternEntity = new Entity("Lantern", "Untagged");
+        Entity *lanternEntity = Entity::Create("Lantern", "Untagged");
         lanternEntity->AddBehaviour<Model>("Assets/Models/Lantern/Lantern.obj");
         lanternEntity->transform.SetPosition(glm::vec3(0.0f, -4.0f, 15.0f));
         lanternEntity->transform.SetRotation(glm::quat(glm::radians(glm::vec3(0.0f, -90.0f, 0.0f))));
-
-        entities.push_back(std::unique_ptr<Entity>(cameraEntity));
-        entities.push_back(std::unique_ptr<Entity>(mainLightEntity));
-        entities.push_back(std::unique_ptr<Entity>(pointLightParent));
-        entities.push_back(std::unique_ptr<Entity>(spotLightEntity));
-        entities.push_back(std::unique_ptr<Entity>(flowerEntity));
-        entities.push_back(std::unique_ptr<Entity>(lanternEntity));
-        entities.push_back(std::unique_ptr<Entity>(floorEntity));
     }
 
     Game::~Game()
     {
+        // Behaviours release their GL resources on destruction, so the context must still be alive
+        EntityPool::Instance().DestroyAll();
+        EntityPool::Instance().FlushDestroyed();
+        delete shader;
+
         window->Terminate();
         delete window;
     }
@@ -93,27 +90,78 @@ namespace Vosgi
         window->Run();
     }
 
+    void Game::Update(float deltaTime)
+    {
+        // Input
+        if (Camera *camera = GetMainCamera())
+        {
+            camera->keyControl(keys, deltaTime);
+        }
+
+        // Update -> LateUpdate with transform propagation
+        scene.Update(deltaTime);
+    }
+
     void Game::Draw(float deltaTime, unsigned int &displayCount, unsigned int &drawCount, unsigned int &entityCount)
     {
-        camera->keyControl(keys, deltaTime);
+        if (Camera *camera = GetMainCamera())
+        {
+            const Frustum& frustum = camera->getFrustum();
+            scene.Cull(*camera, static_cast<float>(window->GetBufferHeight()));
 
-        shader->Use();
+            shader->Use();
 
-        shinyMaterial.Use(*shader);
+            scene.Draw(frustum, *shader, shinyMaterial, displayCount, drawCount);
+        }
+        entityCount = scene.GetEntityCount();
 
-        Frustum frustum = camera->getFrustum();
+        ImGui::Begin("Hierarchy");
 
-        for (auto &entity : entities)
+        // Culling through the entity hierarchy pays off for scenes built as nested groups
+        int cullMode = static_cast<int>(scene.GetCullMode());
+        const char *cullModes[] = {"AABB Tree", "Hierarchy", "Temporal"};
+        if (ImGui::Combo("Culling", &cullMode, cullModes, IM_ARRAYSIZE(cullModes)))
         {
-            entity->DrawSelfAndChildren(deltaTime, frustum, *shader, displayCount, drawCount, entityCount);
+            scene.SetCullMode(static_cast<Scene::CullMode>(cullMode));
+        }
 
-            ImGui::Begin("Hierarchy");
+        float minScreenSize = scene.GetMinScreenSize();
+        if (ImGui::SliderFloat("Min Screen Size", &minScreenSize, 0.f, 64.f))
+        {
+            scene.SetMinScreenSize(minScreenSize);
+        }
+
+        bool occlusionCulling = scene.GetOcclusionCulling();
+        if (ImGui::Checkbox("Occlusion Culling", &occlusionCulling))
+        {
+            scene.SetOcclusionCulling(occlusionCulling);
+        }
+
+        // Without GL 4.3 the queue keeps drawing one batch per call either way
+        bool multiDrawIndirect = scene.GetRenderQueue().IsMultiDrawIndirect();
+        if (ImGui::Checkbox("Multi Draw Indirect", &multiDrawIndirect))
+        {
+            scene.GetRenderQueue().SetMultiDrawIndirect(multiDrawIndirect);
+        }
+
+        for (Entity *entity = scene.GetFirstRoot(); entity; entity = entity->GetNextSibling())
+        {
             entity->DrawInspector();
-            ImGui::End();
         }
+        ImGui::End();
 
         // Unbind shader
         glUseProgram(0);
+
+        // Entities destroyed during the frame are released once nothing refers to them anymore
+        scene.EndFrame();
+    }
+
+    Camera *Game::GetMainCamera() const
+    {
+        // O(1) through the tag index, and never a camera destroyed since the last call
+        Entity *cameraEntity = Entity::FindByTag("MainCamera"_sid);
+        return cameraEntity ? cameraEntity->GetExactBehaviour<Camera>() : nullptr;
     }
 
     void Game::KeyCallback(int key, int scancode, int action, int mods)
@@ -156,7 +204,10 @@ namespace Vosgi
         lastX = (GLfloat)xPos;
         lastY = (GLfloat)yPos;
 
-        camera->mouseControl(xChange, yChange);
+        if (Camera *camera = GetMainCamera())
+        {
+            camera->mouseControl(xChange, yChange);
+        }
     }
 
     void Game::ScrollCallback(double xOffset, double yOffset)
@@ -164,6 +215,10 @@ namespace Vosgi
         if (!window->GetMouseEnabled())
             return;
 
+        Camera *camera = GetMainCamera();
+        if (!camera)
+            return;
+
         // control camera fov
         float fov = camera->getFov() - static_cast<float>(yOffset);
         fov = glm::clamp(fov, 1.0f, 120.0f);
@@ -0,0 +1,205 @@
+#include "../Public/GeometryBuffer.h"
+
+#include <algorithm>
+
+#include "../Public/Affine.h"
+#include "../Public/Mesh.h"
+
+namespace Vosgi
+{
+    namespace
+    {
+        // Room for the first models without growing
+        constexpr uint32_t InitialVertexCapacity = 1 << 16;
+        constexpr uint32_t InitialIndexCapacity = 1 << 18;
+    }
+
+    GeometryBuffer& GeometryBuffer::Main()
+    {
+        // Never destroyed, the context is gone by the time statics are
+        static GeometryBuffer* buffer = new GeometryBuffer();
+        return *buffer;
+    }
+
+    bool GeometryBuffer::SupportsMultiDrawIndirect()
+    {
+        return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+    }
+
+    GeometryBuffer::Range GeometryBuffer::Allocate(const std::vector<Vertex>& vertexData, const std::vector<unsigned int>& indexData)
+    {
+        if (vertexArray == 0) CreateVertexArray();
+
+        Range range;
+        range.vertexCount = static_cast<uint32_t>(vertexData.size());
+        range.indexCount = static_cast<uint32_t>(indexData.size());
+
+        if (!vertices.Allocate(range.vertexCount, range.firstVertex))
+        {
+            const uint32_t capacity = std::max(vertices.capacity * 2, vertices.capacity + range.vertexCount);
+            vertexBuffer = Grow(vertexBuffer, vertices.capacity * sizeof(Vertex), capacity * sizeof(Vertex));
+            vertices.Grow(capacity);
+            vertices.Allocate(range.vertexCount, range.firstVertex);
+
+            // The attributes point at the buffer object, not its storage
+            glBindVertexArray(vertexArray);
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, position));
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, normal));
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, texCoords));
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        if (!indices.Allocate(range.indexCount, range.firstIndex))
+        {
+            const uint32_t capacity = std::max(indices.capacity * 2, indices.capacity + range.indexCount);
+            indexBuffer = Grow(indexBuffer, indices.capacity * sizeof(unsigned int), capacity * sizeof(unsigned int));
+            indices.Grow(capacity);
+            indices.Allocate(range.indexCount, range.firstIndex);
+
+            glBindVertexArray(vertexArray);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+            glBindVertexArray(0);
+        }
+
+        // Upload through the copy target, the element array binding would change the bound vertex array
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, range.firstVertex * sizeof(Vertex), vertexData.size() * sizeof(Vertex), vertexData.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, range.firstIndex * sizeof(unsigned int), indexData.size() * sizeof(unsigned int), indexData.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        return range;
+    }
+
+    void GeometryBuffer::Free(const Range& range)
+    {
+        vertices.Free(range.firstVertex, range.vertexCount);
+        indices.Free(range.firstIndex, range.indexCount);
+    }
+
+    void GeometryBuffer::BindInstances(GLuint buffer, size_t offset)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        for (GLuint row = 0; row < 3; ++row)
+        {
+            glEnableVertexAttribArray(Mesh::InstanceAttribute + row);
+            glVertexAttribPointer(Mesh::InstanceAttribute + row, 4, GL_FLOAT, GL_FALSE, sizeof(Affine), (void *)(offset + row * sizeof(glm::vec4)));
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void GeometryBuffer::UnbindInstances()
+    {
+        for (GLuint row = 0; row < 3; ++row)
+        {
+            glDisableVertexAttribArray(Mesh::InstanceAttribute + row);
+        }
+    }
+
+    void GeometryBuffer::CreateVertexArray()
+    {
+        vertexBuffer = Grow(0, 0, InitialVertexCapacity * sizeof(Vertex));
+        indexBuffer = Grow(0, 0, InitialIndexCapacity * sizeof(unsigned int));
+        vertices.Grow(InitialVertexCapacity);
+        indices.Grow(InitialIndexCapacity);
+
+        glGenVertexArrays(1, &vertexArray);
+        glBindVertexArray(vertexArray);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+        // Position
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, position));
+
+        // Normal
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, normal));
+
+        // Texture coordinates
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, texCoords));
+
+        // World matrix rows, one per instance, enabled by BindInstances
+        for (GLuint row = 0; row < 3; ++row)
+        {
+            glVertexAttribDivisor(Mesh::InstanceAttribute + row, 1);
+        }
+
+        // Unbind the vertex array first, so it keeps the index buffer
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    GLuint GeometryBuffer::Grow(GLuint buffer, size_t size, size_t newSize)
+    {
+        GLuint grown;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+
+        if (buffer != 0)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glDeleteBuffers(1, &buffer);
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return grown;
+    }
+
+    bool GeometryBuffer::FreeList::Allocate(uint32_t count, uint32_t& offset)
+    {
+        if (count == 0)
+        {
+            offset = 0;
+            return true;
+        }
+
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            auto& [begin, size] = blocks[i];
+            if (size < count) continue;
+
+            offset = begin;
+            begin += count;
+            size -= count;
+            if (size == 0) blocks.erase(blocks.begin() + static_cast<std::ptrdiff_t>(i));
+            return true;
+        }
+        return false;
+    }
+
+    void GeometryBuffer::FreeList::Free(uint32_t offset, uint32_t count)
+    {
+        if (count == 0) return;
+
+        auto next = std::lower_bound(blocks.begin(), blocks.end(), std::make_pair(offset, 0u));
+        auto block = blocks.insert(next, {offset, count});
+
+        // Merge with the following block, then with the previous one
+        if (block + 1 != blocks.end() && block->first + block->second == (block + 1)->first)
+        {
+            block->second += (block + 1)->second;
+            blocks.erase(block + 1);
+        }
+        if (block != blocks.begin() && (block - 1)->first + (block - 1)->second == block->first)
+        {
+            (block - 1)->second += block->second;
+            blocks.erase(block);
+        }
+    }
+
+    void GeometryBuffer::FreeList::Grow(uint32_t newCapacity)
+    {
+        const uint32_t added = newCapacity - capacity;
+        const uint32_t offset = capacity;
+        capacity = newCapacity;
+        Free(offset, added);
+    }
+} // namespace Vosgi
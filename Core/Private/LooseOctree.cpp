@@ -0,0 +1,342 @@
+#include "../Public/LooseOctree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Vosgi
+{
+    namespace
+    {
+        // Node bounds are their cell scaled by this factor
+        constexpr float Looseness = 2.0f;
+
+        bool Overlaps(const glm::vec3& centerA, const glm::vec3& extentsA, const glm::vec3& centerB, const glm::vec3& extentsB)
+        {
+            const glm::vec3 distance = glm::abs(centerA - centerB);
+            const glm::vec3 reach = extentsA + extentsB;
+            return distance.x <= reach.x && distance.y <= reach.y && distance.z <= reach.z;
+        }
+
+        bool OverlapsSphere(const glm::vec3& center, const glm::vec3& extents, const glm::vec3& point, float radius)
+        {
+            const glm::vec3 closest = glm::min(glm::max(point, center - extents), center + extents);
+            const glm::vec3 offset = closest - point;
+            return glm::dot(offset, offset) <= radius * radius;
+        }
+
+        bool OverlapsFrustum(const glm::vec3& center, const glm::vec3& extents, const Frustum& frustum)
+        {
+            const Plane* planes[6] = {&frustum.leftFace, &frustum.rightFace, &frustum.farFace,
+                                      &frustum.nearFace, &frustum.topFace, &frustum.bottomFace};
+            for (const Plane* plane : planes)
+            {
+                const glm::vec3& n = plane->normal;
+                const float radius = extents.x * std::abs(n.x) + extents.y * std::abs(n.y) + extents.z * std::abs(n.z);
+                if (plane->getSignedDistanceToPlane(center) < -radius) return false;
+            }
+            return true;
+        }
+
+        // Direction components below this are treated as parallel to their slabs
+        constexpr float ParallelEpsilon = 1e-8f;
+
+        struct Ray
+        {
+            glm::vec3 origin;
+            glm::vec3 inverseDirection;
+            bool parallel[3];
+        };
+
+        // Slab test, returns the entry distance or a negative value on a miss
+        float IntersectRay(const glm::vec3& center, const glm::vec3& extents, const Ray& ray, float maxDistance)
+        {
+            float enter = 0.0f;
+            float exit = maxDistance;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float low = center[axis] - extents[axis] - ray.origin[axis];
+                const float high = center[axis] + extents[axis] - ray.origin[axis];
+
+                // A parallel ray is inside the slab everywhere or nowhere, and 0 * inf on its planes would be NaN
+                if (ray.parallel[axis])
+                {
+                    if (low > 0.0f || high < 0.0f) return -1.0f;
+                    continue;
+                }
+
+                const float t0 = low * ray.inverseDirection[axis];
+                const float t1 = high * ray.inverseDirection[axis];
+                enter = std::max(enter, std::min(t0, t1));
+                exit = std::min(exit, std::max(t0, t1));
+            }
+            return enter <= exit ? enter : -1.0f;
+        }
+    }
+
+    LooseOctree::LooseOctree(const glm::vec3& center, float halfSize, uint32_t maxDepth)
+        : rootCenter(center), rootHalfSize(halfSize), maxDepth(std::min(maxDepth, 20u))
+    {
+        Node root;
+        root.center = center;
+        root.halfSize = halfSize;
+        nodes.push_back(std::move(root));
+    }
+
+    LooseOctree& LooseOctree::Main()
+    {
+        static LooseOctree octree(glm::vec3(0.0f), 2048.0f, 8);
+        return octree;
+    }
+
+    LooseOctree::EntryId LooseOctree::Insert(EntityHandle handle, const AABB& bounds)
+    {
+        EntryId entry;
+        if (freeEntry != NullEntry)
+        {
+            entry = freeEntry;
+            freeEntry = entries[entry].node;
+        }
+        else
+        {
+            entry = static_cast<EntryId>(entries.size());
+            entries.emplace_back();
+        }
+
+        Entry& data = entries[entry];
+        data.handle = handle;
+        data.center = bounds.center;
+        data.extents = bounds.extents;
+
+        Link(entry, GetOrCreateNode(FindCell(bounds.center, bounds.extents)));
+        ++count;
+        return entry;
+    }
+
+    void LooseOctree::Remove(EntryId entry)
+    {
+        const int32_t node = entries[entry].node;
+        Unlink(entry);
+        Prune(node);
+
+        entries[entry].handle = EntityHandle();
+        entries[entry].node = freeEntry;
+        freeEntry = entry;
+        --count;
+    }
+
+    void LooseOctree::Update(EntryId entry, const AABB& bounds)
+    {
+        Entry& data = entries[entry];
+        data.center = bounds.center;
+        data.extents = bounds.extents;
+
+        const Cell cell = FindCell(bounds.center, bounds.extents);
+        const int32_t node = data.node;
+        if (IsInCell(nodes[node], cell)) return;
+
+        Unlink(entry);
+        Link(entry, GetOrCreateNode(cell));
+        Prune(node);
+    }
+
+    void LooseOctree::QueryBox(const AABB& box, std::vector<EntityHandle>& out) const
+    {
+        Traverse([&](const glm::vec3& center, const glm::vec3& extents) { return Overlaps(center, extents, box.center, box.extents); },
+                 [&](const Entry& entry) {
+                     if (Overlaps(entry.center, entry.extents, box.center, box.extents)) out.push_back(entry.handle);
+                 });
+    }
+
+    void LooseOctree::QuerySphere(const glm::vec3& center, float radius, std::vector<EntityHandle>& out) const
+    {
+        Traverse([&](const glm::vec3& nodeCenter, const glm::vec3& extents) { return OverlapsSphere(nodeCenter, extents, center, radius); },
+                 [&](const Entry& entry) {
+                     if (OverlapsSphere(entry.center, entry.extents, center, radius)) out.push_back(entry.handle);
+                 });
+    }
+
+    void LooseOctree::QueryFrustum(const Frustum& frustum, std::vector<EntityHandle>& out) const
+    {
+        Traverse([&](const glm::vec3& center, const glm::vec3& extents) { return OverlapsFrustum(center, extents, frustum); },
+                 [&](const Entry& entry) {
+                     if (OverlapsFrustum(entry.center, entry.extents, frustum)) out.push_back(entry.handle);
+                 });
+    }
+
+    bool LooseOctree::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+    {
+        Ray ray;
+        ray.origin = origin;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            ray.parallel[axis] = std::abs(direction[axis]) < ParallelEpsilon;
+            ray.inverseDirection[axis] = ray.parallel[axis] ? 0.0f : 1.0f / direction[axis];
+        }
+
+        float nearest = maxDistance;
+        bool found = false;
+
+        // Nodes further than the nearest hit so far are skipped
+        Traverse([&](const glm::vec3& center, const glm::vec3& extents) {
+                     return IntersectRay(center, extents, ray, nearest) >= 0.0f;
+                 },
+                 [&](const Entry& entry) {
+                     const float distance = IntersectRay(entry.center, entry.extents, ray, nearest);
+                     if (distance < 0.0f) return;
+
+                     nearest = distance;
+                     hit.handle = entry.handle;
+                     hit.distance = distance;
+                     found = true;
+                 });
+
+        return found;
+    }
+
+    template <typename NodeTest, typename EntryFunc>
+    void LooseOctree::Traverse(NodeTest&& nodeTest, EntryFunc&& entryFunc) const
+    {
+        std::vector<int32_t> stack;
+        stack.push_back(0);
+
+        while (!stack.empty())
+        {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+
+            // The root also holds the entries outside its cell, so it is never rejected
+            if (node.depth > 0 && !nodeTest(node.center, glm::vec3(node.halfSize * Looseness))) continue;
+
+            for (EntryId entry : node.entries)
+            {
+                entryFunc(entries[entry]);
+            }
+
+            if (node.childCount == 0) continue;
+            for (int32_t child : node.children)
+            {
+                if (child >= 0) stack.push_back(child);
+            }
+        }
+    }
+
+    LooseOctree::Cell LooseOctree::FindCell(const glm::vec3& center, const glm::vec3& extents) const
+    {
+        Cell cell;
+
+        const glm::vec3 offset = center - (rootCenter - glm::vec3(rootHalfSize));
+        const float size = std::max(std::max(extents.x, extents.y), extents.z);
+        const float rootSize = 2.0f * rootHalfSize;
+        if (size > rootHalfSize || offset.x < 0.0f || offset.y < 0.0f || offset.z < 0.0f ||
+            offset.x >= rootSize || offset.y >= rootSize || offset.z >= rootSize)
+        {
+            return cell;
+        }
+
+        // Deepest level whose cells are at least as large as the entry
+        float halfSize = rootHalfSize;
+        while (cell.depth < maxDepth && halfSize * 0.5f >= size)
+        {
+            halfSize *= 0.5f;
+            ++cell.depth;
+        }
+
+        const uint32_t last = (1u << cell.depth) - 1;
+        const float cellSize = 2.0f * halfSize;
+        cell.x = std::min(static_cast<uint32_t>(offset.x / cellSize), last);
+        cell.y = std::min(static_cast<uint32_t>(offset.y / cellSize), last);
+        cell.z = std::min(static_cast<uint32_t>(offset.z / cellSize), last);
+        return cell;
+    }
+
+    bool LooseOctree::IsInCell(const Node& node, const Cell& cell) const
+    {
+        if (node.depth != cell.depth) return false;
+
+        // Cell coordinates of the node, from its center
+        const float cellSize = 2.0f * node.halfSize;
+        const glm::vec3 corner = node.center - glm::vec3(node.halfSize) - (rootCenter - glm::vec3(rootHalfSize));
+        return static_cast<uint32_t>(corner.x / cellSize + 0.5f) == cell.x &&
+               static_cast<uint32_t>(corner.y / cellSize + 0.5f) == cell.y &&
+               static_cast<uint32_t>(corner.z / cellSize + 0.5f) == cell.z;
+    }
+
+    int32_t LooseOctree::GetOrCreateNode(const Cell& cell)
+    {
+        int32_t index = 0;
+        for (uint32_t depth = 1; depth <= cell.depth; ++depth)
+        {
+            // Bits of the cell coordinates select the child at each level, from the top
+            const uint32_t shift = cell.depth - depth;
+            const int childIndex = static_cast<int>(((cell.x >> shift) & 1) | (((cell.y >> shift) & 1) << 1) | (((cell.z >> shift) & 1) << 2));
+
+            int32_t child = nodes[index].children[childIndex];
+            if (child < 0)
+            {
+                if (!freeNodes.empty())
+                {
+                    child = freeNodes.back();
+                    freeNodes.pop_back();
+                }
+                else
+                {
+                    child = static_cast<int32_t>(nodes.size());
+                    nodes.emplace_back();
+                }
+
+                const Node& parent = nodes[index];
+                const float halfSize = parent.halfSize * 0.5f;
+                const glm::vec3 direction((childIndex & 1) ? 1.0f : -1.0f, (childIndex & 2) ? 1.0f : -1.0f, (childIndex & 4) ? 1.0f : -1.0f);
+
+                Node& node = nodes[child];
+                node.center = parent.center + direction * halfSize;
+                node.halfSize = halfSize;
+                node.depth = depth;
+                node.parent = index;
+                node.childCount = 0;
+                std::fill(std::begin(node.children), std::end(node.children), -1);
+                node.entries.clear();
+
+                nodes[index].children[childIndex] = child;
+                ++nodes[index].childCount;
+            }
+            index = child;
+        }
+        return index;
+    }
+
+    void LooseOctree::Link(EntryId entry, int32_t node)
+    {
+        entries[entry].node = node;
+        entries[entry].slot = static_cast<uint32_t>(nodes[node].entries.size());
+        nodes[node].entries.push_back(entry);
+    }
+
+    void LooseOctree::Unlink(EntryId entry)
+    {
+        auto& list = nodes[entries[entry].node].entries;
+        const uint32_t slot = entries[entry].slot;
+
+        // Swap-remove, fixing the slot of the entry moved into the gap
+        list[slot] = list.back();
+        entries[list[slot]].slot = slot;
+        list.pop_back();
+    }
+
+    void LooseOctree::Prune(int32_t index)
+    {
+        while (index > 0 && nodes[index].entries.empty() && nodes[index].childCount == 0)
+        {
+            const int32_t parent = nodes[index].parent;
+            for (auto& child : nodes[parent].children)
+            {
+                if (child == index) child = -1;
+            }
+            --nodes[parent].childCount;
+
+            freeNodes.push_back(index);
+            index = parent;
+        }
+    }
+} // namespace Vosgi
@@ -2,12 +2,16 @@
 
 #include "../Public/Shader.h"
 
+unsigned int Material::nextId = 1;
+
 Material::Material()
 {
+    id = nextId++;
 }
 
 Material::Material(GLfloat sIntensity, GLfloat shine)
 {
+    id = nextId++;
     specularIntensity = sIntensity;
     shininess = shine;
 }
@@ -1,8 +1,31 @@
 #include "../Public/Mesh.h"
 
+#include <map>
+#include <utility>
+
 #include "../Public/MeshData.h"
 #include "../Public/Shader.h"
 
+namespace
+{
+    // Id of every distinct list of textures, 0 being no texture
+    unsigned int GetTextureSetId(const std::vector<Texture>& textures)
+    {
+        static std::map<std::vector<std::pair<unsigned int, std::string>>, unsigned int> sets;
+
+        if (textures.empty()) return 0;
+
+        std::vector<std::pair<unsigned int, std::string>> set;
+        for (const auto& texture : textures)
+        {
+            set.emplace_back(texture.id, texture.type);
+        }
+
+        const auto it = sets.emplace(std::move(set), static_cast<unsigned int>(sets.size() + 1)).first;
+        return it->second;
+    }
+}
+
 Mesh::Mesh() {}
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
@@ -14,35 +37,27 @@ void Mesh::Update(std::vector<Vertex> vertices, std::vector<unsigned int> indice
 {
     SubMesh subMesh = SubMesh(vertices, indices, textures);
 
-    glGenVertexArrays(1, &subMesh.VAO);
-    glBindVertexArray(subMesh.VAO);
-
-    glGenBuffers(1, &subMesh.IBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, subMesh.IBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    glGenBuffers(1, &subMesh.VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, subMesh.VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-    // Position
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, position));
-
-    // Normal
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, normal));
-
-    // Texture coordinates
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, texCoords));
+    boundsMin = vertices.empty() ? glm::vec3(0.0f) : vertices.front().position;
+    boundsMax = boundsMin;
+    for (const auto& vertex : vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    // The previous geometry, if any, goes back to the shared buffers
+    if (id != 0) Vosgi::GeometryBuffer::Main().Free(range);
 
-    glBindVertexArray(0);
+    range = Vosgi::GeometryBuffer::Main().Allocate(vertices, indices);
+    subMesh.VAO = Vosgi::GeometryBuffer::Main().GetVertexArray();
+    subMesh.VBO = 0;
+    subMesh.IBO = 0;
 
     meshFilter = subMesh;
+    textureSet = GetTextureSetId(textures);
+
+    static unsigned int nextId = 1;
+    id = nextId++;
 }
 
 void Mesh::ActivateTextures(Shader& shader)
@@ -71,42 +86,44 @@ void Mesh::Draw(Shader& shader)
 {
     ActivateTextures(shader);
 
-    // Draw mesh
+    // Draw mesh, the index buffer is part of the vertex array state
     glBindVertexArray(meshFilter.VAO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshFilter.IBO);
-
-    // Draw the triangles
-    glDrawElements(GL_TRIANGLES, static_cast<int>(meshFilter.indices.size()), GL_UNSIGNED_INT, nullptr);
+    DrawElements();
 
     // Unbind
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
 
-void Mesh::Clear()
+void Mesh::DrawElements() const
 {
-    if (meshFilter.IBO != 0)
-    {
-        glDeleteBuffers(1, &meshFilter.IBO);
-        meshFilter.IBO = 0;
-    }
+    glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<int>(range.indexCount), GL_UNSIGNED_INT,
+                             (void *)(range.firstIndex * sizeof(unsigned int)), static_cast<GLint>(range.firstVertex));
+}
 
-    if (meshFilter.VBO != 0)
-    {
-        glDeleteBuffers(1, &meshFilter.VBO);
-        meshFilter.VBO = 0;
-    }
+void Mesh::DrawElementsInstanced(int count) const
+{
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<int>(range.indexCount), GL_UNSIGNED_INT,
+                                      (void *)(range.firstIndex * sizeof(unsigned int)), count, static_cast<GLint>(range.firstVertex));
+}
 
-    if (meshFilter.VAO != 0)
+void Mesh::Clear()
+{
+    // The buffers are shared, only the range is owned
+    if (id != 0)
     {
-        glDeleteVertexArrays(1, &meshFilter.VAO);
-        meshFilter.VAO = 0;
+        Vosgi::GeometryBuffer::Main().Free(range);
+        range = Vosgi::GeometryBuffer::Range();
+        id = 0;
     }
 
     meshFilter.indices.clear();
     meshFilter.vertices.clear();
     meshFilter.textures.clear();
     meshFilter = SubMesh();
+
+    boundsMin = glm::vec3(0.0f);
+    boundsMax = glm::vec3(0.0f);
+    textureSet = 0;
 }
 
 Mesh::~Mesh()
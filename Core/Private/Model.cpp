@@ -3,8 +3,30 @@
 #include <filesystem>
 #include <stb/stb_image.h>
 
+#include "../Public/Profiler.h"
 #include "../Public/Shader.h"
 
+struct Model::MeshSet
+{
+    std::vector<Mesh*> meshes;
+    // Key in loadedMeshSets, empty for meshes that were not loaded from a file
+    std::string path;
+
+    ~MeshSet()
+    {
+        // The last model using the file is gone, so is its entry
+        if (!path.empty()) loadedMeshSets.erase(path);
+
+        for (auto& mesh : meshes)
+        {
+            mesh->Clear();
+            delete mesh;
+        }
+    }
+};
+
+std::map<std::string, std::weak_ptr<Model::MeshSet>> Model::loadedMeshSets = std::map<std::string, std::weak_ptr<Model::MeshSet>>();
+
 Model::Model() : Behaviour()
 {
     aabb = std::make_unique<Vosgi::AABB>();
@@ -12,83 +34,141 @@ Model::Model() : Behaviour()
 
 Model::Model(const char* path) : Behaviour()
 {
-    LoadModel(path);
+    std::weak_ptr<MeshSet>& loaded = loadedMeshSets[path];
+    meshSet = loaded.lock();
+    if (!meshSet)
+    {
+        LoadModel(path);
+        meshSet = std::make_shared<MeshSet>();
+        meshSet->meshes = meshes;
+        meshSet->path = path;
+        loaded = meshSet;
+    }
+    meshes = meshSet->meshes;
+
     aabb = std::make_unique<Vosgi::AABB>(Vosgi::generateAABB(meshes));
 }
 
 Model::Model(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
 {
-    meshes.push_back(new Mesh(vertices, indices, textures));
+    meshSet = std::make_shared<MeshSet>();
+    meshSet->meshes.push_back(new Mesh(vertices, indices, textures));
+    meshes = meshSet->meshes;
     aabb = std::make_unique<Vosgi::AABB>(Vosgi::generateAABB(meshes));
 }
 
 Model::~Model()
 {
+    DestroyCullProxy();
     Clear();
 }
 
-void Model::Draw(const Frustum& frustum, Shader& shader, unsigned int& display, unsigned int& draw)
+void Model::OnEnable()
+{
+    if (cullProxy != Vosgi::AABBTree::NullProxy || !transform) return;
+
+    const Vosgi::AABB bounds = GetWorldAABB();
+    cullProxy = Vosgi::AABBTree::Main().CreateProxy(bounds.center - bounds.extents, bounds.center + bounds.extents, this);
+
+    // Have the entity's spatial entry pick up the model bounds on the next update
+    transform->SetDirty();
+}
+
+void Model::OnDisable()
 {
-    if (!aabb->isOnFrustum(frustum, *transform)) return;
+    if (cullProxy == Vosgi::AABBTree::NullProxy) return;
+    DestroyCullProxy();
+
+    // Have the entity's subtree bounds drop the model on the next update
+    transform->SetDirty();
+}
+
+void Model::DestroyCullProxy()
+{
+    if (cullProxy == Vosgi::AABBTree::NullProxy) return;
+
+    Vosgi::AABBTree::Main().DestroyProxy(cullProxy);
+    cullProxy = Vosgi::AABBTree::NullProxy;
+}
 
-    if (m_isWireframe)
+Vosgi::AABB Model::UpdateBounds()
+{
+    const Vosgi::AABB bounds = GetWorldAABB();
+    if (cullProxy != Vosgi::AABBTree::NullProxy)
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        Vosgi::AABBTree::Main().MoveProxy(cullProxy, bounds.center - bounds.extents, bounds.center + bounds.extents);
     }
+    return bounds;
+}
+
+void Model::Draw(const Frustum& frustum, Shader& shader, unsigned int& display, unsigned int& draw)
+{
+    // Drawn on its own, outside the scene's render queue
+    Vosgi::RenderQueue queue;
+    Enqueue(queue, frustum, shader, nullptr, transform->GetWorldPosition(), display, draw);
+    queue.Submit();
+}
 
-    shader.SetMat4("model", transform->GetModel());
+void Model::Enqueue(Vosgi::RenderQueue& queue, const Frustum& frustum, Shader& shader, Material* material, const glm::vec3& eye, unsigned int& display, unsigned int& draw)
+{
+    const Vosgi::Affine& model = transform->GetModel();
+    Material* meshMaterial = m_material ? m_material : material;
+
+    // The model as a whole passed culling, a single mesh needs no further test
+    const bool cullMeshes = meshes.size() > 1;
+    unsigned int culled = 0;
     for (auto& mesh : meshes)
     {
-        mesh->Draw(shader);
+        const Vosgi::AABB bounds = Vosgi::AABB(mesh->GetBoundsMin(), mesh->GetBoundsMax()).GetTransformed(model);
+        if (cullMeshes && !bounds.isOnFrustum(frustum))
+        {
+            ++culled;
+            continue;
+        }
+
+        queue.Add(*mesh, model, shader, meshMaterial, glm::length(bounds.center - eye), m_isTransparent, m_isWireframe);
         ++draw;
     }
     ++display;
 
-    if (m_isWireframe)
-    {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    }
+    if (culled > 0) Vosgi::Profiler::AddCount("Submeshes Culled", culled);
 }
 
 void Model::Clear()
 {
-    for (auto& mesh : meshes)
-    {
-        mesh->Clear();
-        delete mesh;
-    }
+    // The last model using the meshes deletes them
     meshes.clear();
-    delete transform;
+    meshSet.reset();
 }
 
 void Model::DrawInspector()
 {
     ImGui::Checkbox("Wireframe", &m_isWireframe);
+    ImGui::Checkbox("Occluder", &m_isOccluder);
+    ImGui::Checkbox("Transparent", &m_isTransparent);
+
+    // Negative falls back to the scene's threshold
+    ImGui::SliderFloat("Min Screen Size", &m_minScreenSize, -1.f, 64.f);
 }
 
-Vosgi::AABB* Model::GetWorldAABB()
+Vosgi::AABB Model::GetWorldAABB() const
 {
-    // Get global scale thanks to our transform
-    const glm::vec3 globalCenter{transform->GetModel() * glm::vec4(aabb->center, 1.f)};
-
-    // Scaled orientation
-    const glm::vec3 right = transform->GetRight() * aabb->extents.x;
-    const glm::vec3 up = transform->GetUp() * aabb->extents.y;
-    const glm::vec3 forward = transform->GetForward() * aabb->extents.z;
-
-    const float newIi = std::abs(glm::dot(glm::vec3{1.f, 0.f, 0.f}, right)) +
-                        std::abs(glm::dot(glm::vec3{1.f, 0.f, 0.f}, up)) +
-                        std::abs(glm::dot(glm::vec3{1.f, 0.f, 0.f}, forward));
+    return aabb->GetTransformed(transform->GetModel());
+}
 
-    const float newIj = std::abs(glm::dot(glm::vec3{0.f, 1.f, 0.f}, right)) +
-                        std::abs(glm::dot(glm::vec3{0.f, 1.f, 0.f}, up)) +
-                        std::abs(glm::dot(glm::vec3{0.f, 1.f, 0.f}, forward));
+void Model::AddOccluders(Vosgi::OcclusionBuffer& buffer) const
+{
+    static_assert(sizeof(unsigned int) == sizeof(uint32_t), "Mesh indices are passed as uint32_t");
 
-    const float newIk = std::abs(glm::dot(glm::vec3{0.f, 0.f, 1.f}, right)) +
-                        std::abs(glm::dot(glm::vec3{0.f, 0.f, 1.f}, up)) +
-                        std::abs(glm::dot(glm::vec3{0.f, 0.f, 1.f}, forward));
+    const Vosgi::Affine& model = transform->GetModel();
+    for (const auto& mesh : meshes)
+    {
+        const std::vector<Vertex>& vertices = mesh->GetVertices();
+        const std::vector<unsigned int>& indices = mesh->GetIndices();
+        if (vertices.empty()) continue;
 
-    return new Vosgi::AABB(globalCenter, newIi, newIj, newIk);
+        buffer.AddOccluder(&vertices[0].position, sizeof(Vertex), indices.data(), indices.size(), model);
+    }
 }
 
 void Model::LoadModel(const std::string& fileName)
@@ -0,0 +1,478 @@
+#include "../Public/OcclusionBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "../Public/SIMD.h"
+
+namespace Vosgi
+{
+    namespace
+    {
+        // Rows rasterized by one worker at a time
+        constexpr uint32_t BandHeight = 16;
+
+        // Triangles set up by one worker at a time
+        constexpr size_t SetupChunk = 1024;
+
+        // Clip-space w below which a vertex counts as behind the camera
+        constexpr float MinW = 1e-5f;
+
+        // Pixels this close outside an edge are covered, so rounding cannot open cracks along shared edges
+        constexpr float EdgeTolerance = 1e-3f;
+
+        // A box is tested against at most this many texels per axis of the pyramid
+        constexpr int32_t MaxTexelSpan = 4;
+
+        // Widest SIMD span, rows are padded so a span can always finish with a full vector
+        constexpr uint32_t MaxLanes = 8;
+
+        // Edge functions and depth at the first pixel of a row, and their change per pixel
+        struct Span
+        {
+            float edge[3];
+            float step[3];
+            float depth;
+            float depthStep;
+        };
+
+        void SpanScalar(const Span& span, float* depth, int32_t count)
+        {
+            for (int32_t i = 0; i < count; ++i)
+            {
+                const float x = static_cast<float>(i);
+                const float e0 = span.edge[0] + span.step[0] * x;
+                const float e1 = span.edge[1] + span.step[1] * x;
+                const float e2 = span.edge[2] + span.step[2] * x;
+                if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f) continue;
+
+                depth[i] = std::min(depth[i], span.depth + span.depthStep * x);
+            }
+        }
+
+#if VOSGI_SIMD_X86
+        void SpanSSE2(const Span& span, float* depth, int32_t count)
+        {
+            const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+            const __m128 zero = _mm_setzero_ps();
+
+            // The last iteration may run past count, into pixels of the same row or its padding
+            for (int32_t i = 0; i < count; i += 4)
+            {
+                const __m128 x = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lanes);
+                const __m128 e0 = _mm_add_ps(_mm_set1_ps(span.edge[0]), _mm_mul_ps(_mm_set1_ps(span.step[0]), x));
+                const __m128 e1 = _mm_add_ps(_mm_set1_ps(span.edge[1]), _mm_mul_ps(_mm_set1_ps(span.step[1]), x));
+                const __m128 e2 = _mm_add_ps(_mm_set1_ps(span.edge[2]), _mm_mul_ps(_mm_set1_ps(span.step[2]), x));
+                const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+
+                const __m128 z = _mm_add_ps(_mm_set1_ps(span.depth), _mm_mul_ps(_mm_set1_ps(span.depthStep), x));
+                const __m128 current = _mm_loadu_ps(depth + i);
+                const __m128 nearest = _mm_min_ps(current, z);
+                _mm_storeu_ps(depth + i, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+            }
+        }
+
+        VOSGI_TARGET_AVX2 void SpanAVX2(const Span& span, float* depth, int32_t count)
+        {
+            const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+            const __m256 zero = _mm256_setzero_ps();
+
+            for (int32_t i = 0; i < count; i += 8)
+            {
+                const __m256 x = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lanes);
+                const __m256 e0 = _mm256_fmadd_ps(_mm256_set1_ps(span.step[0]), x, _mm256_set1_ps(span.edge[0]));
+                const __m256 e1 = _mm256_fmadd_ps(_mm256_set1_ps(span.step[1]), x, _mm256_set1_ps(span.edge[1]));
+                const __m256 e2 = _mm256_fmadd_ps(_mm256_set1_ps(span.step[2]), x, _mm256_set1_ps(span.edge[2]));
+                const __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ), _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)),
+                                                    _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(inside) == 0) continue;
+
+                const __m256 z = _mm256_fmadd_ps(_mm256_set1_ps(span.depthStep), x, _mm256_set1_ps(span.depth));
+                const __m256 current = _mm256_loadu_ps(depth + i);
+                _mm256_storeu_ps(depth + i, _mm256_blendv_ps(current, _mm256_min_ps(current, z), inside));
+            }
+        }
+#endif
+
+        void RasterizeSpan(SIMD::Level level, const Span& span, float* depth, int32_t count)
+        {
+            switch (level)
+            {
+#if VOSGI_SIMD_X86
+            case SIMD::Level::AVX2:
+                SpanAVX2(span, depth, count);
+                break;
+            case SIMD::Level::SSE2:
+                SpanSSE2(span, depth, count);
+                break;
+#endif
+            default:
+                SpanScalar(span, depth, count);
+                break;
+            }
+        }
+    }
+
+    /**
+     * \brief Threads kept alive between frames, woken to run the same job together.
+     * The job pulls its work items from an atomic counter until there are none left.
+     */
+    struct OcclusionBuffer::Workers
+    {
+        explicit Workers(uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                threads.emplace_back([this] { Loop(); });
+            }
+        }
+
+        ~Workers()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+            }
+            wake.notify_all();
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+        // Run the job on every worker and on the calling thread, return once all of them finished
+        void Run(const std::function<void()>& function)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = function;
+                busy = static_cast<uint32_t>(threads.size());
+                ++generation;
+            }
+            wake.notify_all();
+
+            function();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return busy == 0; });
+        }
+
+        void Loop()
+        {
+            uint64_t seen = 0;
+            while (true)
+            {
+                std::function<void()> function;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return quit || generation != seen; });
+                    if (quit) return;
+
+                    seen = generation;
+                    function = job;
+                }
+
+                function();
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--busy == 0) done.notify_one();
+            }
+        }
+
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+
+        std::function<void()> job;
+        uint64_t generation = 0;
+        uint32_t busy = 0;
+        bool quit = false;
+    };
+
+    OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height, uint32_t threadCount)
+        : width(std::max(width, 1u)), height(std::max(height, 1u)), stride(this->width + MaxLanes - 1),
+          bandCount((this->height + BandHeight - 1) / BandHeight),
+          bins(bandCount), workers(std::make_unique<Workers>(threadCount > 1 ? threadCount - 1 : 0))
+    {
+        // Every level halves the previous one, rounding up, down to a single texel
+        uint32_t levelWidth = stride, levelHeight = this->height;
+        while (true)
+        {
+            Level level;
+            level.width = levelWidth;
+            level.height = levelHeight;
+            level.depth.assign(static_cast<size_t>(levelWidth) * levelHeight, 1.0f);
+            levels.push_back(std::move(level));
+
+            if (levelWidth == 1 && levelHeight == 1) break;
+            levelWidth = (levelWidth + 1) / 2;
+            levelHeight = (levelHeight + 1) / 2;
+        }
+    }
+
+    OcclusionBuffer::~OcclusionBuffer() = default;
+
+    uint32_t OcclusionBuffer::GetDefaultThreadCount()
+    {
+        const uint32_t cores = std::thread::hardware_concurrency();
+        return std::clamp(cores / 2, 1u, 8u);
+    }
+
+    void OcclusionBuffer::Begin(const glm::mat4& matrix)
+    {
+        viewProjection = matrix;
+        occluders.clear();
+        firstTriangles.assign(1, 0);
+        std::fill(levels[0].depth.begin(), levels[0].depth.end(), 1.0f);
+    }
+
+    void OcclusionBuffer::AddOccluder(const glm::vec3* positions, size_t stride, const uint32_t* indices, size_t indexCount, const Affine& world)
+    {
+        if (indexCount < 3) return;
+
+        Occluder occluder;
+        occluder.positions = positions;
+        occluder.stride = stride;
+        occluder.indices = indices;
+        occluder.toClip = viewProjection * world.ToMat4();
+        occluders.push_back(occluder);
+        firstTriangles.push_back(firstTriangles.back() + indexCount / 3);
+    }
+
+    void OcclusionBuffer::Rasterize()
+    {
+        const size_t triangleCount = firstTriangles.back();
+        triangles.resize(triangleCount);
+        accepted.resize(triangleCount);
+
+        // Set up the triangles in chunks, each worker finding the occluder of its chunk once
+        std::atomic<size_t> nextChunk{0};
+        workers->Run([&] {
+            for (size_t begin = nextChunk.fetch_add(SetupChunk); begin < triangleCount; begin = nextChunk.fetch_add(SetupChunk))
+            {
+                const size_t end = std::min(begin + SetupChunk, triangleCount);
+                size_t occluder = static_cast<size_t>(std::upper_bound(firstTriangles.begin(), firstTriangles.end(), begin) - firstTriangles.begin()) - 1;
+
+                for (size_t triangle = begin; triangle < end; ++triangle)
+                {
+                    while (triangle >= firstTriangles[occluder + 1]) ++occluder;
+                    accepted[triangle] = SetupTriangle(occluders[occluder], triangle - firstTriangles[occluder], triangles[triangle]);
+                }
+            }
+        });
+
+        // Bin into every band each triangle overlaps, in submission order
+        rasterizedCount = 0;
+        for (auto& bin : bins)
+        {
+            bin.clear();
+        }
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            if (!accepted[triangle]) continue;
+            ++rasterizedCount;
+
+            const Triangle& t = triangles[triangle];
+            const uint32_t lastBand = static_cast<uint32_t>(t.maxY) / BandHeight;
+            for (uint32_t band = static_cast<uint32_t>(t.minY) / BandHeight; band <= lastBand; ++band)
+            {
+                bins[band].push_back(static_cast<uint32_t>(triangle));
+            }
+        }
+
+        // Bands cover distinct rows, so the workers never write the same pixel
+        std::atomic<uint32_t> nextBand{0};
+        workers->Run([&] {
+            for (uint32_t band = nextBand++; band < bandCount; band = nextBand++)
+            {
+                RasterizeBand(band);
+            }
+        });
+
+        BuildPyramid();
+    }
+
+    bool OcclusionBuffer::SetupTriangle(const Occluder& occluder, size_t triangle, Triangle& out) const
+    {
+        float x[3], y[3], z[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            const uint32_t index = occluder.indices[triangle * 3 + i];
+            const auto* position = reinterpret_cast<const glm::vec3*>(reinterpret_cast<const uint8_t*>(occluder.positions) + index * occluder.stride);
+            const glm::vec4 clip = occluder.toClip * glm::vec4(*position, 1.0f);
+
+            // Clipping would add vertices, dropping the triangle only loses some occlusion
+            if (clip.w < MinW) return false;
+
+            const float inverseW = 1.0f / clip.w;
+            x[i] = (clip.x * inverseW * 0.5f + 0.5f) * static_cast<float>(width);
+            y[i] = (clip.y * inverseW * 0.5f + 0.5f) * static_cast<float>(height);
+            z[i] = clip.z * inverseW * 0.5f + 0.5f;
+        }
+
+        // Back faces are behind the front ones of a closed mesh, skipping them loses nothing
+        const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (!(area > 0.0f)) return false;
+
+        // Pixels whose center is inside the bounds
+        out.minX = std::max(0, static_cast<int32_t>(std::ceil(std::min({x[0], x[1], x[2]}) - 0.5f)));
+        out.minY = std::max(0, static_cast<int32_t>(std::ceil(std::min({y[0], y[1], y[2]}) - 0.5f)));
+        out.maxX = std::min(static_cast<int32_t>(width) - 1, static_cast<int32_t>(std::floor(std::max({x[0], x[1], x[2]}) - 0.5f)));
+        out.maxY = std::min(static_cast<int32_t>(height) - 1, static_cast<int32_t>(std::floor(std::max({y[0], y[1], y[2]}) - 0.5f)));
+        if (out.minX > out.maxX || out.minY > out.maxY) return false;
+
+        // Distance in pixels to the left of each edge, which is the inside of a counter-clockwise triangle
+        for (int i = 0; i < 3; ++i)
+        {
+            const int j = (i + 1) % 3;
+            const float inverseLength = 1.0f / std::sqrt((y[i] - y[j]) * (y[i] - y[j]) + (x[j] - x[i]) * (x[j] - x[i]));
+            out.edgeA[i] = (y[i] - y[j]) * inverseLength;
+            out.edgeB[i] = (x[j] - x[i]) * inverseLength;
+            out.edgeC[i] = EdgeTolerance - (out.edgeA[i] * x[i] + out.edgeB[i] * y[i]);
+        }
+
+        // Depth after the perspective divide is linear in screen space
+        const float inverseArea = 1.0f / area;
+        out.depthX = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) * inverseArea;
+        out.depthY = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) * inverseArea;
+        out.depthC = z[0] - out.depthX * x[0] - out.depthY * y[0];
+        return true;
+    }
+
+    void OcclusionBuffer::RasterizeBand(uint32_t band)
+    {
+        const SIMD::Level level = SIMD::GetLevel();
+        const int32_t bandMin = static_cast<int32_t>(band * BandHeight);
+        const int32_t bandMax = std::min(bandMin + static_cast<int32_t>(BandHeight), static_cast<int32_t>(height)) - 1;
+        float* depth = levels[0].depth.data();
+
+        for (uint32_t index : bins[band])
+        {
+            const Triangle& t = triangles[index];
+            const int32_t rowMin = std::max(t.minY, bandMin);
+            const int32_t rowMax = std::min(t.maxY, bandMax);
+            const float left = static_cast<float>(t.minX) + 0.5f;
+
+            Span span;
+            for (int i = 0; i < 3; ++i)
+            {
+                span.step[i] = t.edgeA[i];
+            }
+            span.depthStep = t.depthX;
+
+            for (int32_t row = rowMin; row <= rowMax; ++row)
+            {
+                const float center = static_cast<float>(row) + 0.5f;
+                float edge[3];
+                for (int i = 0; i < 3; ++i)
+                {
+                    edge[i] = t.edgeA[i] * left + t.edgeB[i] * center + t.edgeC[i];
+                }
+
+                // Pixels of the row inside all three edges, widened by one as the span tests them again
+                float first = 0.0f, last = static_cast<float>(t.maxX - t.minX);
+                for (int i = 0; i < 3; ++i)
+                {
+                    if (t.edgeA[i] > 0.0f)
+                        first = std::max(first, -edge[i] / t.edgeA[i] - 1.0f);
+                    else if (t.edgeA[i] < 0.0f)
+                        last = std::min(last, -edge[i] / t.edgeA[i] + 1.0f);
+                    else if (edge[i] < 0.0f)
+                        last = -1.0f;
+                }
+                if (first > last) continue;
+
+                const int32_t begin = static_cast<int32_t>(std::ceil(first));
+                const int32_t end = static_cast<int32_t>(std::floor(last));
+                const float offset = static_cast<float>(begin);
+                for (int i = 0; i < 3; ++i)
+                {
+                    span.edge[i] = edge[i] + t.edgeA[i] * offset;
+                }
+                span.depth = t.depthX * (left + offset) + t.depthY * center + t.depthC;
+
+                RasterizeSpan(level, span, depth + static_cast<size_t>(row) * stride + t.minX + begin, end - begin + 1);
+            }
+        }
+    }
+
+    void OcclusionBuffer::BuildPyramid()
+    {
+        for (size_t i = 1; i < levels.size(); ++i)
+        {
+            const Level& source = levels[i - 1];
+            Level& level = levels[i];
+
+            for (uint32_t y = 0; y < level.height; ++y)
+            {
+                const uint32_t y0 = y * 2, y1 = std::min(y0 + 1, source.height - 1);
+                for (uint32_t x = 0; x < level.width; ++x)
+                {
+                    const uint32_t x0 = x * 2, x1 = std::min(x0 + 1, source.width - 1);
+                    const float farthest = std::max(std::max(source.depth[y0 * source.width + x0], source.depth[y0 * source.width + x1]),
+                                                    std::max(source.depth[y1 * source.width + x0], source.depth[y1 * source.width + x1]));
+                    level.depth[y * level.width + x] = farthest;
+                }
+            }
+        }
+    }
+
+    bool OcclusionBuffer::IsVisible(const glm::vec3& center, const glm::vec3& extents) const
+    {
+        constexpr float infinity = std::numeric_limits<float>::infinity();
+        float minX = infinity, minY = infinity, maxX = -infinity, maxY = -infinity;
+        float nearest = infinity;
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const glm::vec3 offset((corner & 1) ? extents.x : -extents.x, (corner & 2) ? extents.y : -extents.y, (corner & 4) ? extents.z : -extents.z);
+            const glm::vec4 clip = viewProjection * glm::vec4(center + offset, 1.0f);
+
+            // Crossing the camera plane, its screen rectangle is unbounded
+            if (clip.w < MinW) return true;
+
+            const float inverseW = 1.0f / clip.w;
+            const float x = clip.x * inverseW, y = clip.y * inverseW;
+            minX = std::min(minX, x), maxX = std::max(maxX, x);
+            minY = std::min(minY, y), maxY = std::max(maxY, y);
+            nearest = std::min(nearest, clip.z * inverseW * 0.5f + 0.5f);
+        }
+
+        // In front of the near plane or offscreen, left to the frustum test
+        if (nearest <= 0.0f || maxX < -1.0f || maxY < -1.0f || minX > 1.0f || minY > 1.0f) return true;
+
+        const auto toPixel = [](float ndc, uint32_t size) {
+            const float pixel = (ndc * 0.5f + 0.5f) * static_cast<float>(size);
+            return std::clamp(static_cast<int32_t>(std::floor(pixel)), 0, static_cast<int32_t>(size) - 1);
+        };
+        int32_t x0 = toPixel(minX, width), x1 = toPixel(maxX, width);
+        int32_t y0 = toPixel(minY, height), y1 = toPixel(maxY, height);
+
+        // The finest level where the rectangle spans only a few texels
+        size_t index = 0;
+        while (index + 1 < levels.size() && (x1 - x0 >= MaxTexelSpan || y1 - y0 >= MaxTexelSpan))
+        {
+            x0 >>= 1, x1 >>= 1, y0 >>= 1, y1 >>= 1;
+            ++index;
+        }
+
+        // Visible as soon as one texel has nothing in front of the box
+        const Level& level = levels[index];
+        for (int32_t y = y0; y <= y1; ++y)
+        {
+            for (int32_t x = x0; x <= x1; ++x)
+            {
+                if (level.depth[static_cast<size_t>(y) * level.width + x] >= nearest) return true;
+            }
+        }
+        return false;
+    }
+} // namespace Vosgi
@@ -0,0 +1,50 @@
+#include "../Public/Profiler.h"
+
+#include <cstring>
+
+namespace Vosgi
+{
+    std::vector<Profiler::Sample> Profiler::samples = std::vector<Profiler::Sample>();
+
+    void Profiler::BeginFrame()
+    {
+        for (auto& sample : samples)
+        {
+            sample.milliseconds = 0.0;
+            sample.count = 0;
+            sample.value = 0.0;
+        }
+    }
+
+    void Profiler::AddTime(const char* name, double milliseconds)
+    {
+        Sample& sample = Find(name);
+        sample.milliseconds += milliseconds;
+        sample.isTimer = true;
+    }
+
+    void Profiler::AddCount(const char* name, unsigned int count)
+    {
+        Find(name).count += count;
+    }
+
+    void Profiler::SetValue(const char* name, double value)
+    {
+        Sample& sample = Find(name);
+        sample.value = value;
+        sample.isValue = true;
+    }
+
+    Profiler::Sample& Profiler::Find(const char* name)
+    {
+        for (auto& sample : samples)
+        {
+            if (sample.name == name || std::strcmp(sample.name, name) == 0) return sample;
+        }
+
+        Sample sample;
+        sample.name = name;
+        samples.push_back(sample);
+        return samples.back();
+    }
+} // namespace Vosgi
@@ -0,0 +1,459 @@
+#include "../Public/Quaternion.h"
+
+#include "../Public/Affine.h"
+#include "../Public/SIMD.h"
+
+namespace Vosgi
+{
+    namespace QuaternionBatch
+    {
+        namespace
+        {
+            // Eberly, "A Fast and Accurate Algorithm for Computing SLERP", coefficients of the
+            // series of sin(t * angle) / sin(angle) in cos(angle) - 1, the last one corrected by mu
+            constexpr float SlerpMu = 1.90110745351730037f;
+            constexpr float SlerpU[8] = {1.0f / (1 * 3), 1.0f / (2 * 5), 1.0f / (3 * 7), 1.0f / (4 * 9),
+                                         1.0f / (5 * 11), 1.0f / (6 * 13), 1.0f / (7 * 15), SlerpMu / (8 * 17)};
+            constexpr float SlerpV[8] = {1.0f / 3, 2.0f / 5, 3.0f / 7, 4.0f / 9,
+                                         5.0f / 11, 6.0f / 13, 7.0f / 15, SlerpMu * 8 / 17};
+
+            // ---- Scalar, also used for the tails of the SIMD loops ----
+
+            void MultiplyScalar(const QuaternionStream& a, const QuaternionStream& b, const QuaternionStream& out, size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const Quaternion result = Quaternion::Multiply(Quaternion(a.x[i], a.y[i], a.z[i], a.w[i]),
+                                                                   Quaternion(b.x[i], b.y[i], b.z[i], b.w[i]));
+                    out.x[i] = result.x, out.y[i] = result.y, out.z[i] = result.z, out.w[i] = result.w;
+                }
+            }
+
+            void RotateScalar(const QuaternionStream& q, const Vec3Stream& v, const Vec3Stream& out, size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const glm::vec3 result = Quaternion::Multiply(Quaternion(q.x[i], q.y[i], q.z[i], q.w[i]), glm::vec3(v.x[i], v.y[i], v.z[i]));
+                    out.x[i] = result.x, out.y[i] = result.y, out.z[i] = result.z;
+                }
+            }
+
+            void NormalizeScalar(const QuaternionStream& q, const QuaternionStream& out, size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const Quaternion result = Quaternion(q.x[i], q.y[i], q.z[i], q.w[i]).normalized();
+                    out.x[i] = result.x, out.y[i] = result.y, out.z[i] = result.z, out.w[i] = result.w;
+                }
+            }
+
+            void NlerpScalar(const QuaternionStream& a, const QuaternionStream& b, const float* t, const QuaternionStream& out, size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const float dot = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i] + a.w[i] * b.w[i];
+                    const float from = 1.0f - t[i];
+                    const float to = dot < 0.0f ? -t[i] : t[i];
+
+                    const Quaternion result = Quaternion(a.x[i] * from + b.x[i] * to, a.y[i] * from + b.y[i] * to,
+                                                         a.z[i] * from + b.z[i] * to, a.w[i] * from + b.w[i] * to).normalized();
+                    out.x[i] = result.x, out.y[i] = result.y, out.z[i] = result.z, out.w[i] = result.w;
+                }
+            }
+
+            void SlerpScalar(const QuaternionStream& a, const QuaternionStream& b, const float* t, const QuaternionStream& out, size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    float dot = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i] + a.w[i] * b.w[i];
+                    const float sign = dot < 0.0f ? -1.0f : 1.0f;
+                    dot *= sign;
+
+                    const float xm1 = dot - 1.0f;
+                    const float d = 1.0f - t[i];
+                    const float sqrT = t[i] * t[i], sqrD = d * d;
+
+                    float from = 1.0f, to = 1.0f;
+                    for (int k = 7; k >= 0; --k)
+                    {
+                        to = 1.0f + (SlerpU[k] * sqrT - SlerpV[k]) * xm1 * to;
+                        from = 1.0f + (SlerpU[k] * sqrD - SlerpV[k]) * xm1 * from;
+                    }
+                    from *= d;
+                    to *= sign * t[i];
+
+                    out.x[i] = a.x[i] * from + b.x[i] * to;
+                    out.y[i] = a.y[i] * from + b.y[i] * to;
+                    out.z[i] = a.z[i] * from + b.z[i] * to;
+                    out.w[i] = a.w[i] * from + b.w[i] * to;
+                }
+            }
+
+            void ToMatrixScalar(const QuaternionStream& q, Affine* out, size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const float x = q.x[i], y = q.y[i], z = q.z[i], w = q.w[i];
+                    const float xx = x * x, yy = y * y, zz = z * z;
+                    const float xy = x * y, xz = x * z, yz = y * z;
+                    const float wx = w * x, wy = w * y, wz = w * z;
+
+                    out[i].rows[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz), 2.0f * (xz + wy), 0.0f);
+                    out[i].rows[1] = glm::vec4(2.0f * (xy + wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx), 0.0f);
+                    out[i].rows[2] = glm::vec4(2.0f * (xz - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (xx + yy), 0.0f);
+                }
+            }
+
+#if VOSGI_SIMD_X86
+            // ---- SSE2, 4 elements per iteration ----
+
+            void MultiplySSE2(const QuaternionStream& a, const QuaternionStream& b, const QuaternionStream& out, size_t count)
+            {
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    const __m128 ax = _mm_loadu_ps(a.x + i), ay = _mm_loadu_ps(a.y + i), az = _mm_loadu_ps(a.z + i), aw = _mm_loadu_ps(a.w + i);
+                    const __m128 bx = _mm_loadu_ps(b.x + i), by = _mm_loadu_ps(b.y + i), bz = _mm_loadu_ps(b.z + i), bw = _mm_loadu_ps(b.w + i);
+
+                    const __m128 x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, bx), _mm_mul_ps(ax, bw)), _mm_mul_ps(ay, bz)), _mm_mul_ps(az, by));
+                    const __m128 y = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, by), _mm_mul_ps(ay, bw)), _mm_mul_ps(az, bx)), _mm_mul_ps(ax, bz));
+                    const __m128 z = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, bz), _mm_mul_ps(az, bw)), _mm_mul_ps(ax, by)), _mm_mul_ps(ay, bx));
+                    const __m128 w = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(aw, bw), _mm_mul_ps(ax, bx)), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+
+                    _mm_storeu_ps(out.x + i, x), _mm_storeu_ps(out.y + i, y), _mm_storeu_ps(out.z + i, z), _mm_storeu_ps(out.w + i, w);
+                }
+                MultiplyScalar(a, b, out, i, count);
+            }
+
+            void RotateSSE2(const QuaternionStream& q, const Vec3Stream& v, const Vec3Stream& out, size_t count)
+            {
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    const __m128 qx = _mm_loadu_ps(q.x + i), qy = _mm_loadu_ps(q.y + i), qz = _mm_loadu_ps(q.z + i), qw = _mm_loadu_ps(q.w + i);
+                    const __m128 vx = _mm_loadu_ps(v.x + i), vy = _mm_loadu_ps(v.y + i), vz = _mm_loadu_ps(v.z + i);
+
+                    // uv = q x v, uuv = q x uv
+                    const __m128 uvx = _mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy));
+                    const __m128 uvy = _mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz));
+                    const __m128 uvz = _mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx));
+                    const __m128 uuvx = _mm_sub_ps(_mm_mul_ps(qy, uvz), _mm_mul_ps(qz, uvy));
+                    const __m128 uuvy = _mm_sub_ps(_mm_mul_ps(qz, uvx), _mm_mul_ps(qx, uvz));
+                    const __m128 uuvz = _mm_sub_ps(_mm_mul_ps(qx, uvy), _mm_mul_ps(qy, uvx));
+
+                    const __m128 two = _mm_set1_ps(2.0f);
+                    _mm_storeu_ps(out.x + i, _mm_add_ps(vx, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(uvx, qw), uuvx), two)));
+                    _mm_storeu_ps(out.y + i, _mm_add_ps(vy, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(uvy, qw), uuvy), two)));
+                    _mm_storeu_ps(out.z + i, _mm_add_ps(vz, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(uvz, qw), uuvz), two)));
+                }
+                RotateScalar(q, v, out, i, count);
+            }
+
+            // Scale x, y, z, w to unit length, zero quaternions become the identity
+            inline void StoreNormalizedSSE2(const QuaternionStream& out, size_t i, __m128 x, __m128 y, __m128 z, __m128 w)
+            {
+                const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))));
+                const __m128 valid = _mm_cmpgt_ps(length, _mm_setzero_ps());
+                const __m128 scale = _mm_and_ps(valid, _mm_div_ps(_mm_set1_ps(1.0f), length));
+                const __m128 identityW = _mm_andnot_ps(valid, _mm_set1_ps(1.0f));
+
+                _mm_storeu_ps(out.x + i, _mm_mul_ps(x, scale));
+                _mm_storeu_ps(out.y + i, _mm_mul_ps(y, scale));
+                _mm_storeu_ps(out.z + i, _mm_mul_ps(z, scale));
+                _mm_storeu_ps(out.w + i, _mm_add_ps(_mm_mul_ps(w, scale), identityW));
+            }
+
+            void NormalizeSSE2(const QuaternionStream& q, const QuaternionStream& out, size_t count)
+            {
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    StoreNormalizedSSE2(out, i, _mm_loadu_ps(q.x + i), _mm_loadu_ps(q.y + i), _mm_loadu_ps(q.z + i), _mm_loadu_ps(q.w + i));
+                }
+                NormalizeScalar(q, out, i, count);
+            }
+
+            // Lanes of to flipped where the dot product is negative, for the shortest path
+            inline __m128 ShortestPathSignSSE2(__m128 dot)
+            {
+                return _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+            }
+
+            inline __m128 Dot4SSE2(__m128 ax, __m128 ay, __m128 az, __m128 aw, __m128 bx, __m128 by, __m128 bz, __m128 bw)
+            {
+                return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+            }
+
+            void NlerpSSE2(const QuaternionStream& a, const QuaternionStream& b, const float* t, const QuaternionStream& out, size_t count)
+            {
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    const __m128 ax = _mm_loadu_ps(a.x + i), ay = _mm_loadu_ps(a.y + i), az = _mm_loadu_ps(a.z + i), aw = _mm_loadu_ps(a.w + i);
+                    const __m128 bx = _mm_loadu_ps(b.x + i), by = _mm_loadu_ps(b.y + i), bz = _mm_loadu_ps(b.z + i), bw = _mm_loadu_ps(b.w + i);
+                    const __m128 lt = _mm_loadu_ps(t + i);
+
+                    const __m128 sign = ShortestPathSignSSE2(Dot4SSE2(ax, ay, az, aw, bx, by, bz, bw));
+                    const __m128 from = _mm_sub_ps(_mm_set1_ps(1.0f), lt);
+                    const __m128 to = _mm_xor_ps(lt, sign);
+
+                    StoreNormalizedSSE2(out, i,
+                                        _mm_add_ps(_mm_mul_ps(ax, from), _mm_mul_ps(bx, to)),
+                                        _mm_add_ps(_mm_mul_ps(ay, from), _mm_mul_ps(by, to)),
+                                        _mm_add_ps(_mm_mul_ps(az, from), _mm_mul_ps(bz, to)),
+                                        _mm_add_ps(_mm_mul_ps(aw, from), _mm_mul_ps(bw, to)));
+                }
+                NlerpScalar(a, b, t, out, i, count);
+            }
+
+            void SlerpSSE2(const QuaternionStream& a, const QuaternionStream& b, const float* t, const QuaternionStream& out, size_t count)
+            {
+                const __m128 one = _mm_set1_ps(1.0f);
+
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    const __m128 ax = _mm_loadu_ps(a.x + i), ay = _mm_loadu_ps(a.y + i), az = _mm_loadu_ps(a.z + i), aw = _mm_loadu_ps(a.w + i);
+                    const __m128 bx = _mm_loadu_ps(b.x + i), by = _mm_loadu_ps(b.y + i), bz = _mm_loadu_ps(b.z + i), bw = _mm_loadu_ps(b.w + i);
+                    const __m128 lt = _mm_loadu_ps(t + i);
+
+                    const __m128 dot = Dot4SSE2(ax, ay, az, aw, bx, by, bz, bw);
+                    const __m128 sign = ShortestPathSignSSE2(dot);
+
+                    const __m128 xm1 = _mm_sub_ps(_mm_xor_ps(dot, sign), one);
+                    const __m128 d = _mm_sub_ps(one, lt);
+                    const __m128 sqrT = _mm_mul_ps(lt, lt), sqrD = _mm_mul_ps(d, d);
+
+                    __m128 from = one, to = one;
+                    for (int k = 7; k >= 0; --k)
+                    {
+                        const __m128 u = _mm_set1_ps(SlerpU[k]), v = _mm_set1_ps(SlerpV[k]);
+                        to = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, sqrT), v), xm1), to));
+                        from = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(u, sqrD), v), xm1), from));
+                    }
+                    from = _mm_mul_ps(from, d);
+                    to = _mm_xor_ps(_mm_mul_ps(to, lt), sign);
+
+                    _mm_storeu_ps(out.x + i, _mm_add_ps(_mm_mul_ps(ax, from), _mm_mul_ps(bx, to)));
+                    _mm_storeu_ps(out.y + i, _mm_add_ps(_mm_mul_ps(ay, from), _mm_mul_ps(by, to)));
+                    _mm_storeu_ps(out.z + i, _mm_add_ps(_mm_mul_ps(az, from), _mm_mul_ps(bz, to)));
+                    _mm_storeu_ps(out.w + i, _mm_add_ps(_mm_mul_ps(aw, from), _mm_mul_ps(bw, to)));
+                }
+                SlerpScalar(a, b, t, out, i, count);
+            }
+
+            void ToMatrixSSE2(const QuaternionStream& q, Affine* out, size_t count)
+            {
+                const __m128 one = _mm_set1_ps(1.0f);
+
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4)
+                {
+                    const __m128 x = _mm_loadu_ps(q.x + i), y = _mm_loadu_ps(q.y + i), z = _mm_loadu_ps(q.z + i), w = _mm_loadu_ps(q.w + i);
+                    const __m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+
+                    const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+                    const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+                    const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+                    __m128 rows[3][4] = {
+                        {_mm_sub_ps(one, _mm_add_ps(yy, zz)), _mm_sub_ps(xy, wz), _mm_add_ps(xz, wy), _mm_setzero_ps()},
+                        {_mm_add_ps(xy, wz), _mm_sub_ps(one, _mm_add_ps(xx, zz)), _mm_sub_ps(yz, wx), _mm_setzero_ps()},
+                        {_mm_sub_ps(xz, wy), _mm_add_ps(yz, wx), _mm_sub_ps(one, _mm_add_ps(xx, yy)), _mm_setzero_ps()},
+                    };
+
+                    // Lanes hold one element each, transpose them into rows
+                    for (int row = 0; row < 3; ++row)
+                    {
+                        _MM_TRANSPOSE4_PS(rows[row][0], rows[row][1], rows[row][2], rows[row][3]);
+                        for (int lane = 0; lane < 4; ++lane)
+                        {
+                            _mm_storeu_ps(&out[i + lane].rows[row].x, rows[row][lane]);
+                        }
+                    }
+                }
+                ToMatrixScalar(q, out, i, count);
+            }
+
+            // ---- AVX2, 8 elements per iteration ----
+
+            VOSGI_TARGET_AVX2 inline void StoreNormalizedAVX2(const QuaternionStream& out, size_t i, __m256 x, __m256 y, __m256 z, __m256 w)
+            {
+                const __m256 length = _mm256_sqrt_ps(_mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_fmadd_ps(z, z, _mm256_mul_ps(w, w)))));
+                const __m256 valid = _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_GT_OQ);
+                const __m256 scale = _mm256_and_ps(valid, _mm256_div_ps(_mm256_set1_ps(1.0f), length));
+                const __m256 identityW = _mm256_andnot_ps(valid, _mm256_set1_ps(1.0f));
+
+                _mm256_storeu_ps(out.x + i, _mm256_mul_ps(x, scale));
+                _mm256_storeu_ps(out.y + i, _mm256_mul_ps(y, scale));
+                _mm256_storeu_ps(out.z + i, _mm256_mul_ps(z, scale));
+                _mm256_storeu_ps(out.w + i, _mm256_fmadd_ps(w, scale, identityW));
+            }
+
+            VOSGI_TARGET_AVX2 void NormalizeAVX2(const QuaternionStream& q, const QuaternionStream& out, size_t count)
+            {
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8)
+                {
+                    StoreNormalizedAVX2(out, i, _mm256_loadu_ps(q.x + i), _mm256_loadu_ps(q.y + i), _mm256_loadu_ps(q.z + i), _mm256_loadu_ps(q.w + i));
+                }
+                NormalizeSSE2(QuaternionStream{q.x + i, q.y + i, q.z + i, q.w + i}, QuaternionStream{out.x + i, out.y + i, out.z + i, out.w + i}, count - i);
+            }
+
+            VOSGI_TARGET_AVX2 void NlerpAVX2(const QuaternionStream& a, const QuaternionStream& b, const float* t, const QuaternionStream& out, size_t count)
+            {
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8)
+                {
+                    const __m256 ax = _mm256_loadu_ps(a.x + i), ay = _mm256_loadu_ps(a.y + i), az = _mm256_loadu_ps(a.z + i), aw = _mm256_loadu_ps(a.w + i);
+                    const __m256 bx = _mm256_loadu_ps(b.x + i), by = _mm256_loadu_ps(b.y + i), bz = _mm256_loadu_ps(b.z + i), bw = _mm256_loadu_ps(b.w + i);
+                    const __m256 lt = _mm256_loadu_ps(t + i);
+
+                    const __m256 dot = _mm256_fmadd_ps(ax, bx, _mm256_fmadd_ps(ay, by, _mm256_fmadd_ps(az, bz, _mm256_mul_ps(aw, bw))));
+                    const __m256 sign = _mm256_and_ps(_mm256_cmp_ps(dot, _mm256_setzero_ps(), _CMP_LT_OQ), _mm256_set1_ps(-0.0f));
+                    const __m256 from = _mm256_sub_ps(_mm256_set1_ps(1.0f), lt);
+                    const __m256 to = _mm256_xor_ps(lt, sign);
+
+                    StoreNormalizedAVX2(out, i,
+                                        _mm256_fmadd_ps(ax, from, _mm256_mul_ps(bx, to)),
+                                        _mm256_fmadd_ps(ay, from, _mm256_mul_ps(by, to)),
+                                        _mm256_fmadd_ps(az, from, _mm256_mul_ps(bz, to)),
+                                        _mm256_fmadd_ps(aw, from, _mm256_mul_ps(bw, to)));
+                }
+                NlerpSSE2(QuaternionStream{a.x + i, a.y + i, a.z + i, a.w + i}, QuaternionStream{b.x + i, b.y + i, b.z + i, b.w + i}, t + i,
+                          QuaternionStream{out.x + i, out.y + i, out.z + i, out.w + i}, count - i);
+            }
+
+            VOSGI_TARGET_AVX2 void SlerpAVX2(const QuaternionStream& a, const QuaternionStream& b, const float* t, const QuaternionStream& out, size_t count)
+            {
+                const __m256 one = _mm256_set1_ps(1.0f);
+
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8)
+                {
+                    const __m256 ax = _mm256_loadu_ps(a.x + i), ay = _mm256_loadu_ps(a.y + i), az = _mm256_loadu_ps(a.z + i), aw = _mm256_loadu_ps(a.w + i);
+                    const __m256 bx = _mm256_loadu_ps(b.x + i), by = _mm256_loadu_ps(b.y + i), bz = _mm256_loadu_ps(b.z + i), bw = _mm256_loadu_ps(b.w + i);
+                    const __m256 lt = _mm256_loadu_ps(t + i);
+
+                    const __m256 dot = _mm256_fmadd_ps(ax, bx, _mm256_fmadd_ps(ay, by, _mm256_fmadd_ps(az, bz, _mm256_mul_ps(aw, bw))));
+                    const __m256 sign = _mm256_and_ps(_mm256_cmp_ps(dot, _mm256_setzero_ps(), _CMP_LT_OQ), _mm256_set1_ps(-0.0f));
+
+                    const __m256 xm1 = _mm256_sub_ps(_mm256_xor_ps(dot, sign), one);
+                    const __m256 d = _mm256_sub_ps(one, lt);
+                    const __m256 sqrT = _mm256_mul_ps(lt, lt), sqrD = _mm256_mul_ps(d, d);
+
+                    __m256 from = one, to = one;
+                    for (int k = 7; k >= 0; --k)
+                    {
+                        const __m256 u = _mm256_set1_ps(SlerpU[k]), v = _mm256_set1_ps(SlerpV[k]);
+                        to = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_fmsub_ps(u, sqrT, v), xm1), to, one);
+                        from = _mm256_fmadd_ps(_mm256_mul_ps(_mm256_fmsub_ps(u, sqrD, v), xm1), from, one);
+                    }
+                    from = _mm256_mul_ps(from, d);
+                    to = _mm256_xor_ps(_mm256_mul_ps(to, lt), sign);
+
+                    _mm256_storeu_ps(out.x + i, _mm256_fmadd_ps(ax, from, _mm256_mul_ps(bx, to)));
+                    _mm256_storeu_ps(out.y + i, _mm256_fmadd_ps(ay, from, _mm256_mul_ps(by, to)));
+                    _mm256_storeu_ps(out.z + i, _mm256_fmadd_ps(az, from, _mm256_mul_ps(bz, to)));
+                    _mm256_storeu_ps(out.w + i, _mm256_fmadd_ps(aw, from, _mm256_mul_ps(bw, to)));
+                }
+                SlerpSSE2(QuaternionStream{a.x + i, a.y + i, a.z + i, a.w + i}, QuaternionStream{b.x + i, b.y + i, b.z + i, b.w + i}, t + i,
+                          QuaternionStream{out.x + i, out.y + i, out.z + i, out.w + i}, count - i);
+            }
+#endif
+        }
+
+        void Multiply(const QuaternionStream& lhs, const QuaternionStream& rhs, const QuaternionStream& out, size_t count)
+        {
+            // Bound by the loads and stores of twelve streams, AVX2 does not help here
+#if VOSGI_SIMD_X86
+            if (SIMD::GetLevel() != SIMD::Level::Scalar)
+            {
+                MultiplySSE2(lhs, rhs, out, count);
+                return;
+            }
+#endif
+            MultiplyScalar(lhs, rhs, out, 0, count);
+        }
+
+        void Rotate(const QuaternionStream& rotation, const Vec3Stream& points, const Vec3Stream& out, size_t count)
+        {
+            // Bound by the loads and stores of ten streams, AVX2 does not help here
+#if VOSGI_SIMD_X86
+            if (SIMD::GetLevel() != SIMD::Level::Scalar)
+            {
+                RotateSSE2(rotation, points, out, count);
+                return;
+            }
+#endif
+            RotateScalar(rotation, points, out, 0, count);
+        }
+
+        void Normalize(const QuaternionStream& rotation, const QuaternionStream& out, size_t count)
+        {
+            switch (SIMD::GetLevel())
+            {
+#if VOSGI_SIMD_X86
+            case SIMD::Level::AVX2:
+                NormalizeAVX2(rotation, out, count);
+                break;
+            case SIMD::Level::SSE2:
+                NormalizeSSE2(rotation, out, count);
+                break;
+#endif
+            default:
+                NormalizeScalar(rotation, out, 0, count);
+                break;
+            }
+        }
+
+        void Nlerp(const QuaternionStream& from, const QuaternionStream& to, const float* t, const QuaternionStream& out, size_t count)
+        {
+            switch (SIMD::GetLevel())
+            {
+#if VOSGI_SIMD_X86
+            case SIMD::Level::AVX2:
+                NlerpAVX2(from, to, t, out, count);
+                break;
+            case SIMD::Level::SSE2:
+                NlerpSSE2(from, to, t, out, count);
+                break;
+#endif
+            default:
+                NlerpScalar(from, to, t, out, 0, count);
+                break;
+            }
+        }
+
+        void Slerp(const QuaternionStream& from, const QuaternionStream& to, const float* t, const QuaternionStream& out, size_t count)
+        {
+            switch (SIMD::GetLevel())
+            {
+#if VOSGI_SIMD_X86
+            case SIMD::Level::AVX2:
+                SlerpAVX2(from, to, t, out, count);
+                break;
+            case SIMD::Level::SSE2:
+                SlerpSSE2(from, to, t, out, count);
+                break;
+#endif
+            default:
+                SlerpScalar(from, to, t, out, 0, count);
+                break;
+            }
+        }
+
+        void ToMatrix(const QuaternionStream& rotation, Affine* out, size_t count)
+        {
+            // Bound by the matrix stores, AVX2 does not help here
+#if VOSGI_SIMD_X86
+            if (SIMD::GetLevel() != SIMD::Level::Scalar)
+            {
+                ToMatrixSSE2(rotation, out, count);
+                return;
+            }
+#endif
+            ToMatrixScalar(rotation, out, 0, count);
+        }
+    } // namespace QuaternionBatch
+} // namespace Vosgi
@@ -0,0 +1,357 @@
+#include "../Public/RenderQueue.h"
+
+#include <bit>
+
+#include <GL/glew.h>
+
+#include "../Public/GeometryBuffer.h"
+#include "../Public/Material.h"
+#include "../Public/Mesh.h"
+#include "../Public/Shader.h"
+
+namespace Vosgi
+{
+    namespace
+    {
+        constexpr int DepthBits = 22;
+        constexpr uint64_t MaxDepth = (uint64_t(1) << DepthBits) - 1;
+
+        uint64_t Field(uint32_t value, int bits)
+        {
+            return value & ((uint64_t(1) << bits) - 1);
+        }
+
+        // Items that can be drawn as instances of the same draw call
+        bool IsSameBatch(const RenderQueue::Item& a, const RenderQueue::Item& b)
+        {
+            return !a.transparent && !b.transparent && a.mesh == b.mesh && a.shader == b.shader &&
+                   a.material == b.material && a.wireframe == b.wireframe;
+        }
+
+        // Batches that can share one multi-draw call, all their state but the mesh being the same
+        bool IsSameBucket(const RenderQueue::Item& a, const RenderQueue::Item& b)
+        {
+            return !a.transparent && !b.transparent && a.shader == b.shader && a.material == b.material &&
+                   a.mesh->GetTextureSet() == b.mesh->GetTextureSet() && a.wireframe == b.wireframe;
+        }
+
+        // The bits of a positive float grow with its value, its top bits are a coarser depth
+        uint64_t QuantizeDepth(float depth)
+        {
+            const uint32_t bits = std::bit_cast<uint32_t>(depth > 0.0f ? depth : 0.0f);
+            return static_cast<uint64_t>(bits >> (31 - DepthBits));
+        }
+    }
+
+    void RenderQueue::Clear()
+    {
+        items.clear();
+        order.clear();
+    }
+
+    void RenderQueue::Add(Mesh& mesh, const Affine& model, Shader& shader, Material* material, float depth, bool transparent, bool wireframe)
+    {
+        Item item;
+        item.key = MakeKey(shader.GetID(), material ? material->GetId() : 0, mesh.GetTextureSet(), mesh.GetId(), depth, transparent, wireframe);
+        item.mesh = &mesh;
+        item.model = &model;
+        item.shader = &shader;
+        item.material = material;
+        item.transparent = transparent;
+        item.wireframe = wireframe;
+
+        order.push_back(static_cast<uint32_t>(items.size()));
+        items.push_back(item);
+    }
+
+    uint64_t RenderQueue::MakeKey(uint32_t program, uint32_t material, uint32_t textures, uint32_t mesh, float depth, bool transparent, bool wireframe)
+    {
+        // 41 bits of state, the same in both passes
+        const uint64_t state = (uint64_t(wireframe) << 40) | (Field(program, 6) << 34) | (Field(material, 10) << 24) |
+                               (Field(textures, 12) << 12) | Field(mesh, 12);
+        const uint64_t quantized = QuantizeDepth(depth);
+
+        if (!transparent) return (state << DepthBits) | quantized;
+        return (uint64_t(1) << 63) | ((MaxDepth - quantized) << 41) | state;
+    }
+
+    void RenderQueue::Sort()
+    {
+        const size_t count = items.size();
+        entries.resize(count);
+        scratch.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            entries[i] = {items[i].key, static_cast<uint32_t>(i)};
+        }
+
+        // Histograms of all eight bytes in one pass
+        uint32_t histograms[8][256] = {};
+        for (const SortEntry& entry : entries)
+        {
+            for (int pass = 0; pass < 8; ++pass)
+            {
+                ++histograms[pass][(entry.key >> (pass * 8)) & 0xFF];
+            }
+        }
+
+        // Least significant byte first, each pass stable
+        for (int pass = 0; pass < 8; ++pass)
+        {
+            uint32_t* histogram = histograms[pass];
+
+            // A byte shared by every key leaves the order unchanged
+            if (count == 0 || histogram[(entries[0].key >> (pass * 8)) & 0xFF] == count) continue;
+
+            uint32_t offset = 0;
+            for (int bucket = 0; bucket < 256; ++bucket)
+            {
+                const uint32_t size = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += size;
+            }
+
+            for (const SortEntry& entry : entries)
+            {
+                scratch[histogram[(entry.key >> (pass * 8)) & 0xFF]++] = entry;
+            }
+            entries.swap(scratch);
+        }
+
+        order.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            order[i] = entries[i].index;
+        }
+    }
+
+    void RenderQueue::BuildBatches(bool indirect)
+    {
+        batches.clear();
+        instances = StreamBuffer::Allocation();
+        commands = StreamBuffer::Allocation();
+        commandCount = 0;
+
+        // Sorting placed the items of a mesh next to each other, unless another mesh aliases its key
+        const auto count = static_cast<uint32_t>(order.size());
+        uint32_t instanceCount = 0;
+        for (uint32_t begin = 0; begin < count;)
+        {
+            const Item& first = items[order[begin]];
+
+            uint32_t end = begin + 1;
+            while (end < count && IsSameBatch(first, items[order[end]])) ++end;
+
+            Batch batch{begin, end - begin, 0};
+            if (!first.transparent)
+            {
+                batch.firstInstance = instanceCount;
+                instanceCount += batch.count;
+                if (indirect) ++commandCount;
+            }
+            batches.push_back(batch);
+            begin = end;
+        }
+
+        if (instanceCount == 0) return;
+
+        // Written in place, the GPU reads them from where they land. One allocation,
+        // so growing the stream buffer cannot unmap the matrices before they are written
+        StreamBuffer& stream = StreamBuffer::Main();
+        const size_t matrixBytes = instanceCount * sizeof(Affine);
+        const StreamBuffer::Allocation allocation = stream.Allocate(matrixBytes + commandCount * sizeof(DrawCommand));
+
+        instances = allocation;
+        instances.size = matrixBytes;
+        if (commandCount != 0)
+        {
+            commands = allocation;
+            commands.data = static_cast<uint8_t*>(allocation.data) + matrixBytes;
+            commands.offset += matrixBytes;
+            commands.size -= matrixBytes;
+        }
+
+        auto* matrices = static_cast<Affine*>(instances.data);
+        auto* command = static_cast<DrawCommand*>(commands.data);
+        for (size_t index = 0; index < batches.size(); ++index)
+        {
+            const Batch& batch = batches[index];
+            const Item& first = items[order[batch.begin]];
+            if (first.transparent) break;
+
+            for (uint32_t i = 0; i < batch.count; ++i)
+            {
+                matrices[batch.firstInstance + i] = *items[order[batch.begin + i]].model;
+            }
+
+            if (index < commandCount)
+            {
+                const GeometryBuffer::Range& range = first.mesh->GetRange();
+                command[index] = {range.indexCount, batch.count, range.firstIndex, static_cast<int32_t>(range.firstVertex), batch.firstInstance};
+            }
+        }
+
+        // Unmaps on the fallback path, draws cannot read a mapped buffer there
+        stream.Flush();
+    }
+
+    RenderQueue::Stats RenderQueue::Submit()
+    {
+        Stats stats;
+        BuildBatches(multiDrawIndirect && GeometryBuffer::SupportsMultiDrawIndirect());
+
+        GeometryBuffer& geometry = GeometryBuffer::Main();
+        if (commandCount != 0) glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.buffer);
+
+        Shader* shader = nullptr;
+        Material* material = nullptr;
+        const Affine* model = nullptr;
+        uint32_t textures = 0;
+        bool texturesBound = false;
+        GLuint vertexArray = 0;
+        bool transparent = false;
+        bool wireframe = false;
+        bool instanced = false;
+        // Byte offset the instance attributes read from, while enabled
+        bool instancesBound = false;
+        size_t instanceOffset = 0;
+
+        for (size_t index = 0; index < batches.size();)
+        {
+            const Batch& batch = batches[index];
+            const Item& item = items[order[batch.begin]];
+
+            if (item.transparent != transparent)
+            {
+                transparent = item.transparent;
+                if (transparent)
+                {
+                    glEnable(GL_BLEND);
+                    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                    glDepthMask(GL_FALSE);
+                }
+                else
+                {
+                    glDisable(GL_BLEND);
+                    glDepthMask(GL_TRUE);
+                }
+            }
+
+            if (item.wireframe != wireframe)
+            {
+                wireframe = item.wireframe;
+                glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
+            }
+
+            // Uniforms belong to the program, switching it invalidates them
+            if (item.shader != shader)
+            {
+                shader = item.shader;
+                shader->Use();
+                ++stats.programs;
+
+                material = nullptr;
+                model = nullptr;
+                texturesBound = false;
+
+                instanced = false;
+                shader->SetBool("instanced", false);
+            }
+
+            if (item.material && item.material != material)
+            {
+                material = item.material;
+                material->Use(*shader);
+                ++stats.materials;
+            }
+
+            if (!texturesBound || item.mesh->GetTextureSet() != textures)
+            {
+                textures = item.mesh->GetTextureSet();
+                texturesBound = true;
+                item.mesh->ActivateTextures(*shader);
+                ++stats.textures;
+            }
+
+            if (item.mesh->GetVAO() != vertexArray)
+            {
+                vertexArray = item.mesh->GetVAO();
+                glBindVertexArray(vertexArray);
+                ++stats.vertexArrays;
+            }
+
+            // Multi-draw: the bucket runs over the following opaque batches with the same state
+            size_t end = index + 1;
+            if (index < commandCount)
+            {
+                while (end < commandCount && IsSameBucket(item, items[order[batches[end].begin]])) ++end;
+            }
+
+            const bool batchInstanced = index < commandCount || batch.count >= MinInstances;
+            if (batchInstanced != instanced)
+            {
+                instanced = batchInstanced;
+                shader->SetBool("instanced", instanced);
+            }
+
+            if (instanced)
+            {
+                // Commands select their matrices by base instance, plain instanced draws by offset
+                const size_t offset = instances.offset + (index < commandCount ? 0 : batch.firstInstance * sizeof(Affine));
+                if (!instancesBound || offset != instanceOffset)
+                {
+                    geometry.BindInstances(instances.buffer, offset);
+                    instancesBound = true;
+                    instanceOffset = offset;
+                }
+
+                if (index < commandCount)
+                {
+                    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void *)(commands.offset + index * sizeof(DrawCommand)), static_cast<GLsizei>(end - index), 0);
+                    stats.commands += static_cast<uint32_t>(end - index);
+                    for (size_t i = index; i < end; ++i)
+                    {
+                        stats.instances += batches[i].count;
+                    }
+                }
+                else
+                {
+                    item.mesh->DrawElementsInstanced(static_cast<int>(batch.count));
+                    stats.instances += batch.count;
+                }
+            }
+            else
+            {
+                // The other draws read the model uniform
+                if (instancesBound)
+                {
+                    geometry.UnbindInstances();
+                    instancesBound = false;
+                }
+
+                if (item.model != model)
+                {
+                    model = item.model;
+                    shader->SetAffine("model", *model);
+                }
+                item.mesh->DrawElements();
+            }
+            ++stats.draws;
+            index = end;
+        }
+
+        // Leave the defaults the rest of the frame expects
+        if (instanced) shader->SetBool("instanced", false);
+        if (instancesBound) geometry.UnbindInstances();
+        if (vertexArray != 0) glBindVertexArray(0);
+        if (commandCount != 0) glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        if (wireframe) glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        if (transparent)
+        {
+            glDisable(GL_BLEND);
+            glDepthMask(GL_TRUE);
+        }
+
+        return stats;
+    }
+} // namespace Vosgi
@@ -0,0 +1,76 @@
+#include "../Public/SIMD.h"
+
+#if VOSGI_SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Vosgi
+{
+    namespace SIMD
+    {
+        namespace
+        {
+            Level DetectLevel()
+            {
+#if VOSGI_SIMD_X86 && defined(_MSC_VER)
+                int info[4];
+                __cpuid(info, 0);
+                const int maxLeaf = info[0];
+
+                __cpuid(info, 1);
+                const bool fma = (info[2] & (1 << 12)) != 0;
+                const bool osxsave = (info[2] & (1 << 27)) != 0;
+                const bool avx = (info[2] & (1 << 28)) != 0;
+
+                // The OS must save the YMM registers on context switches
+                const bool ymmEnabled = osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+
+                bool avx2 = false;
+                if (maxLeaf >= 7)
+                {
+                    __cpuidex(info, 7, 0);
+                    avx2 = (info[1] & (1 << 5)) != 0;
+                }
+
+                return ymmEnabled && avx2 && fma ? Level::AVX2 : Level::SSE2;
+#elif VOSGI_SIMD_X86
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? Level::AVX2 : Level::SSE2;
+#else
+                return Level::Scalar;
+#endif
+            }
+
+            Level supported = DetectLevel();
+            Level current = supported;
+        }
+
+        Level GetSupportedLevel()
+        {
+            return supported;
+        }
+
+        Level GetLevel()
+        {
+            return current;
+        }
+
+        void SetLevel(Level level)
+        {
+            current = level < supported ? level : supported;
+        }
+
+        const char* GetLevelName(Level level)
+        {
+            switch (level)
+            {
+            case Level::AVX2:
+                return "AVX2";
+            case Level::SSE2:
+                return "SSE2";
+            default:
+                return "Scalar";
+            }
+        }
+    } // namespace SIMD
+} // namespace Vosgi
@@ -0,0 +1,444 @@
+#include "../Public/Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "../Public/AABBTree.h"
+#include "../Public/Behaviour.h"
+#include "../Public/Camera.h"
+#include "../Public/Culling.h"
+#include "../Public/DirectionalLight.h"
+#include "../Public/Model.h"
+#include "../Public/PointLight.h"
+#include "../Public/SpotLight.h"
+#include "../Public/Profiler.h"
+#include "../Public/StreamBuffer.h"
+#include "../Public/TransformHierarchy.h"
+
+namespace Vosgi
+{
+    namespace
+    {
+        // Leaves of the culling tree reinserted every frame to keep it balanced
+        constexpr uint32_t RebalanceBudget = 8;
+
+        // How far the frustum planes may drift from the reference ones before temporal results are recomputed:
+        // the offset in world units, and the change of the unit normals (about one degree)
+        constexpr float TemporalMoveThreshold = 0.5f;
+        constexpr float TemporalTurnThreshold = 0.02f;
+
+        // Largest distance from a box to the outer side of a frustum plane, negative or zero when the box is visible
+        float GetOutsideDistance(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extents)
+        {
+            const Plane* planes[6] = {&frustum.leftFace, &frustum.rightFace, &frustum.farFace,
+                                      &frustum.nearFace, &frustum.topFace, &frustum.bottomFace};
+            float outside = -std::numeric_limits<float>::max();
+            for (const Plane* plane : planes)
+            {
+                const glm::vec3& n = plane->normal;
+                const float radius = extents.x * std::abs(n.x) + extents.y * std::abs(n.y) + extents.z * std::abs(n.z);
+                outside = std::max(outside, -(plane->getSignedDistanceToPlane(center) + radius));
+            }
+            return outside;
+        }
+
+        // A point's distance to a plane changes by at most turn * |point - eye| + move between the two frustums
+        bool ExceedsThresholds(const Frustum& from, const Frustum& to, const glm::vec3& eye)
+        {
+            const Plane* fromPlanes[6] = {&from.leftFace, &from.rightFace, &from.farFace, &from.nearFace, &from.topFace, &from.bottomFace};
+            const Plane* toPlanes[6] = {&to.leftFace, &to.rightFace, &to.farFace, &to.nearFace, &to.topFace, &to.bottomFace};
+            for (int i = 0; i < 6; ++i)
+            {
+                const glm::vec3 turn = toPlanes[i]->normal - fromPlanes[i]->normal;
+                const float move = glm::dot(turn, eye) - (toPlanes[i]->distance - fromPlanes[i]->distance);
+                if (glm::length(turn) > TemporalTurnThreshold || std::abs(move) > TemporalMoveThreshold) return true;
+            }
+            return false;
+        }
+
+        // Resolution of the occlusion buffer, independent of the window
+        constexpr uint32_t OcclusionWidth = 320;
+        constexpr uint32_t OcclusionHeight = 180;
+
+        // Run a callback on every active behaviour of every pool
+        template <typename Func>
+        void ForEachActiveBehaviour(Func&& func)
+        {
+            for (auto* pool : ComponentPoolBase::GetPools())
+            {
+                if (!pool) continue;
+
+                const auto& behaviours = pool->GetBehaviours();
+                for (size_t i = 0; i < behaviours.size(); ++i)
+                {
+                    if (!behaviours[i]->IsActive()) continue;
+                    func(*behaviours[i]);
+                }
+            }
+        }
+    }
+
+    void Scene::Update(float deltaTime)
+    {
+        entityCount = 0;
+        for (auto* entity : EntityPool::Instance().GetEntities())
+        {
+            if (entity->enabled) ++entityCount;
+        }
+
+        {
+            Profiler::Scope scope("Update");
+            ForEachActiveBehaviour([deltaTime](Behaviour& behaviour) { behaviour.Update(deltaTime); });
+        }
+
+        // LateUpdate must see the world matrices produced by Update
+        PropagateTransforms();
+
+        {
+            Profiler::Scope scope("LateUpdate");
+            ForEachActiveBehaviour([deltaTime](Behaviour& behaviour) { behaviour.LateUpdate(deltaTime); });
+        }
+
+        // Only what LateUpdate moved (usually cameras) is recomputed here
+        PropagateTransforms();
+
+        SyncBounds();
+    }
+
+    void Scene::Cull(const Camera& camera, float viewportHeight)
+    {
+        {
+            Profiler::Scope scope("Culling");
+
+            const Frustum& frustum = camera.getFrustum();
+            viewPosition = camera.getCameraPosition();
+            if (cullMode == CullMode::Hierarchy)
+                CullHierarchy(frustum);
+            else if (cullMode == CullMode::Temporal)
+                CullTemporal(frustum, viewPosition);
+            else
+                CullTree(frustum);
+
+            Profiler::AddCount("Visible", static_cast<unsigned int>(visibleModels.size()));
+
+            // The projection scales a unit at distance one to this fraction of half the viewport
+            const float pixelsPerUnit = camera.getProjectionMatrix()[1][1] * viewportHeight * 0.5f;
+            CullSmall(viewPosition, pixelsPerUnit);
+        }
+
+        Occlude(camera.getViewProjectionMatrix());
+    }
+
+    void Scene::SetOcclusionCulling(bool value)
+    {
+        if (value && !occlusion) occlusion = std::make_unique<OcclusionBuffer>(OcclusionWidth, OcclusionHeight);
+        if (!value) occlusion.reset();
+    }
+
+    void Scene::Draw(const Frustum& frustum, Shader& shader, Material& material, unsigned int& display, unsigned int& draw)
+    {
+        Profiler::Scope scope("Draw");
+
+        // Scene globals first, so every model is drawn with this frame's camera and lights
+        DrawPool<Camera>(frustum, shader, display, draw);
+        DrawPool<DirectionalLight>(frustum, shader, display, draw);
+        DrawPool<PointLight>(frustum, shader, display, draw);
+        DrawPool<SpotLight>(frustum, shader, display, draw);
+
+        renderQueue.Clear();
+        for (auto* model : drawModels)
+        {
+            model->Enqueue(renderQueue, frustum, shader, &material, viewPosition, display, draw);
+        }
+        renderQueue.Sort();
+
+        const RenderQueue::Stats stats = renderQueue.Submit();
+        Profiler::AddCount("Program Binds", stats.programs);
+        Profiler::AddCount("Material Binds", stats.materials);
+        Profiler::AddCount("Texture Binds", stats.textures);
+        Profiler::AddCount("Vertex Array Binds", stats.vertexArrays);
+        Profiler::AddCount("State Changes", stats.GetStateChanges());
+        Profiler::AddCount("Draw Calls", stats.draws);
+        Profiler::AddCount("Instances", stats.instances);
+        Profiler::AddCount("Indirect Commands", stats.commands);
+        Profiler::AddCount("Stream Buffer Bytes", static_cast<unsigned int>(StreamBuffer::Main().GetUsed()));
+    }
+
+    void Scene::EndFrame()
+    {
+        EntityPool::Instance().FlushDestroyed();
+    }
+
+    void Scene::SyncBounds()
+    {
+        Profiler::Scope scope("Bounds");
+
+        movedModels.clear();
+
+        // Only the entities whose world matrix changed need their bounds refitted
+        const bool trackMoved = cullMode == CullMode::Temporal;
+        TransformHierarchy::Main().ConsumeMoved([this, trackMoved](Transform& transform) {
+            Entity* entity = transform.GetEntity();
+            if (!entity || !entity->GetHandle().IsValid()) return;
+
+            entity->UpdateBounds();
+            if (!trackMoved) return;
+            if (Model* model = entity->GetExactBehaviour<Model>()) movedModels.push_back(model);
+        });
+    }
+
+    void Scene::CullViews(const std::vector<Frustum>& frustums, std::vector<std::vector<Model*>>& drawLists)
+    {
+        Profiler::Scope scope("View Culling");
+
+        viewBounds.Clear();
+        viewModels.clear();
+        ComponentPool<Model>::Instance().ForEach([this](Model& model) {
+            if (!model.IsActive()) return;
+
+            const AABB bounds = model.GetWorldAABB();
+            viewBounds.Add(bounds.center, bounds.extents);
+            viewModels.push_back(&model);
+        });
+
+        // One view is cheaper as one bit per model than as one mask per model
+        if (frustums.size() == 1)
+        {
+            Culling::FrustumCull(frustums[0], viewBounds, viewVisibility);
+            drawLists.resize(1);
+            drawLists[0].clear();
+            Culling::ForEachVisible(viewVisibility, [&](size_t index) { drawLists[0].push_back(viewModels[index]); });
+            return;
+        }
+
+        const size_t viewCount = std::min(frustums.size(), Culling::MaxViews);
+        Culling::MultiFrustumCull(frustums.data(), viewCount, viewBounds, viewMasks);
+
+        Culling::GatherViews(viewMasks, viewModels, viewCount, drawLists);
+    }
+
+    void Scene::CullTree(const Frustum& frustum)
+    {
+        AABBTree& tree = AABBTree::Main();
+        tree.Rebalance(RebalanceBudget);
+
+        // A still camera over a still scene sees the same models
+        if (cullValid && tree.GetVersion() == cullVersion && frustum == cullFrustum)
+        {
+            Profiler::AddCount("Culling Reused");
+            Profiler::SetValue("Planes Per Test", cullPlanesPerTest);
+            return;
+        }
+
+        visibleModels.clear();
+        const Culling::PlaneStats stats = tree.QueryFrustum(frustum, visibleModels);
+
+        cullFrustum = frustum;
+        cullVersion = tree.GetVersion();
+        cullValid = true;
+
+        // Proportional to the visible models, or to the whole scene once scanning it is cheaper
+        Profiler::AddCount("Culling Tests", stats.boxes);
+        cullPlanesPerTest = stats.GetPlanesPerBox();
+        Profiler::SetValue("Planes Per Test", cullPlanesPerTest);
+    }
+
+    void Scene::CullHierarchy(const Frustum& frustum)
+    {
+        // Refit only descends into the branches something moved in
+        for (Entity* root = GetFirstRoot(); root; root = root->GetNextSibling())
+        {
+            root->RefitSubtreeBounds();
+        }
+
+        visibleModels.clear();
+        Culling::PlaneStats stats;
+        for (Entity* root = GetFirstRoot(); root; root = root->GetNextSibling())
+        {
+            CullSubtree(*root, frustum, Culling::AllPlanes, stats);
+        }
+
+        // Proportional to the visible branches rather than to the whole scene
+        Profiler::AddCount("Culling Tests", stats.boxes);
+        cullPlanesPerTest = stats.GetPlanesPerBox();
+        Profiler::SetValue("Planes Per Test", cullPlanesPerTest);
+    }
+
+    void Scene::CullTemporal(const Frustum& frustum, const glm::vec3& eye)
+    {
+        // Watched models are only kept while none was destroyed
+        if (!cullValid || AABBTree::Main().GetMembershipVersion() != cullMembership || ExceedsThresholds(cullFrustum, frustum, cullEye))
+        {
+            RefreshTemporal(frustum, eye);
+        }
+        else if (movedModels.empty() && frustum == temporalFrustum)
+        {
+            // A still camera over a still scene sees the same models
+            Profiler::AddCount("Culling Reused");
+            Profiler::SetValue("Planes Per Test", cullPlanesPerTest);
+            return;
+        }
+        temporalFrustum = frustum;
+
+        // A model that moved may have come close to the frustum
+        for (Model* model : movedModels)
+        {
+            if (!model->IsActive() || model->cacheWatched || model->cacheVersion == model->transform->GetVersion()) continue;
+            ClassifyTemporal(*model);
+        }
+
+        visibleModels.clear();
+        Culling::PlaneStats stats;
+        for (Model* model : watchedModels)
+        {
+            uint8_t planes = Culling::AllPlanes;
+            const AABB bounds = model->GetWorldAABB();
+            if (Culling::TestPlanes(frustum, bounds.center, bounds.extents, planes, model->cacheRejectingPlane, stats))
+            {
+                visibleModels.push_back(model);
+            }
+        }
+
+        // Proportional to the models near the frustum rather than to the whole scene
+        Profiler::AddCount("Culling Tests", stats.boxes);
+        cullPlanesPerTest = stats.GetPlanesPerBox();
+        Profiler::SetValue("Planes Per Test", cullPlanesPerTest);
+    }
+
+    void Scene::RefreshTemporal(const Frustum& frustum, const glm::vec3& eye)
+    {
+        cullFrustum = frustum;
+        cullEye = eye;
+        cullMembership = AABBTree::Main().GetMembershipVersion();
+        cullValid = true;
+
+        watchedModels.clear();
+        ComponentPool<Model>::Instance().ForEach([this](Model& model) {
+            model.cacheWatched = false;
+            if (model.IsActive()) ClassifyTemporal(model);
+        });
+
+        Profiler::AddCount("Culling Refreshed");
+    }
+
+    void Scene::ClassifyTemporal(Model& model)
+    {
+        model.cacheVersion = model.transform->GetVersion();
+
+        // Outside by more than the planes can drift within the thresholds, the model stays hidden
+        const AABB bounds = model.GetWorldAABB();
+        const float outside = GetOutsideDistance(cullFrustum, bounds.center, bounds.extents);
+        const float drift = TemporalTurnThreshold * (glm::length(bounds.center - cullEye) + glm::length(bounds.extents)) + TemporalMoveThreshold;
+        if (outside > drift) return;
+
+        model.cacheWatched = true;
+        watchedModels.push_back(&model);
+    }
+
+    void Scene::CullSmall(const glm::vec3& eye, float pixelsPerUnit)
+    {
+        drawModels.clear();
+
+        unsigned int tooSmall = 0;
+        for (Model* candidate : visibleModels)
+        {
+            const float threshold = candidate->GetMinScreenSize() >= 0.0f ? candidate->GetMinScreenSize() : minScreenSize;
+            const AABB bounds = candidate->GetWorldAABB();
+
+            // The bounding sphere covers 2 * radius * pixelsPerUnit / distance pixels, compared without dividing
+            const glm::vec3 offset = bounds.center - eye;
+            const float diameter = 2.0f * glm::length(bounds.extents) * pixelsPerUnit;
+            if (glm::dot(offset, offset) * threshold * threshold > diameter * diameter)
+            {
+                ++tooSmall;
+                continue;
+            }
+            drawModels.push_back(candidate);
+        }
+
+        Profiler::AddCount("Too Small", tooSmall);
+    }
+
+    void Scene::Occlude(const glm::mat4& viewProjection)
+    {
+        if (!occlusion) return;
+
+        Profiler::Scope scope("Occlusion");
+
+        // Only the occluders that passed the other tests can hide anything
+        occlusion->Begin(viewProjection);
+        for (Model* model : drawModels)
+        {
+            if (model->IsOccluder()) model->AddOccluders(*occlusion);
+        }
+        occlusion->Rasterize();
+
+        // Occluders are large and drawn regardless, the rest must show through the depth buffer
+        const size_t count = drawModels.size();
+        drawModels.erase(std::remove_if(drawModels.begin(), drawModels.end(), [this](Model* model) {
+                             if (model->IsOccluder()) return false;
+                             const AABB bounds = model->GetWorldAABB();
+                             return !occlusion->IsVisible(bounds.center, bounds.extents);
+                         }),
+                         drawModels.end());
+
+        Profiler::AddCount("Occluder Triangles", static_cast<unsigned int>(occlusion->GetRasterizedCount()));
+        Profiler::AddCount("Occluded", static_cast<unsigned int>(count - drawModels.size()));
+    }
+
+    void Scene::CullSubtree(Entity& entity, const Frustum& frustum, uint8_t planes, Culling::PlaneStats& stats)
+    {
+        AABB bounds;
+        if (!entity.GetSubtreeBounds(bounds)) return;
+
+        if (!Culling::TestPlanes(frustum, bounds.center, bounds.extents, planes, entity.subtreeRejectingPlane, stats)) return;
+
+        // Fully inside, nothing below needs testing
+        if (planes == 0)
+        {
+            CollectSubtree(entity);
+            return;
+        }
+
+        Model* model = entity.GetExactBehaviour<Model>();
+        if (model && model->IsActive())
+        {
+            // Without children the subtree bounds are the model's own, which just passed
+            if (!entity.GetFirstChild())
+            {
+                visibleModels.push_back(model);
+                return;
+            }
+
+            uint8_t modelPlanes = planes;
+            const AABB modelBounds = model->GetWorldAABB();
+            if (Culling::TestPlanes(frustum, modelBounds.center, modelBounds.extents, modelPlanes, entity.modelRejectingPlane, stats))
+            {
+                visibleModels.push_back(model);
+            }
+        }
+
+        for (Entity* child = entity.GetFirstChild(); child; child = child->GetNextSibling())
+        {
+            CullSubtree(*child, frustum, planes, stats);
+        }
+    }
+
+    void Scene::CollectSubtree(Entity& entity)
+    {
+        Model* model = entity.GetExactBehaviour<Model>();
+        if (model && model->IsActive()) visibleModels.push_back(model);
+
+        for (Entity* child = entity.GetFirstChild(); child; child = child->GetNextSibling())
+        {
+            CollectSubtree(*child);
+        }
+    }
+
+    void Scene::PropagateTransforms()
+    {
+        Profiler::Scope scope("Hierarchy");
+        TransformHierarchy::Main().Update();
+    }
+} // namespace Vosgi
@@ -1,9 +1,29 @@
 #include "../Public/Shader.h"
 
-// initialize static map of shaders
-std::map<std::string, GLuint> Shader::uniformLocations = std::map<std::string, GLuint>();
+#include "../Public/UniformBlocks.h"
+
+// initialize static list of shaders
 std::vector<Shader*> Shader::shaders = std::vector<Shader*>();
 
+namespace
+{
+    // glUniform* targets the bound program, so bind each one in turn and restore the current one after
+    template <typename Func>
+    void ForEachProgram(const std::vector<Shader*>& shaders, Func&& func)
+    {
+        GLint current = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+
+        for (auto& shader : shaders)
+        {
+            shader->Use();
+            func(*shader);
+        }
+
+        glUseProgram(static_cast<GLuint>(current));
+    }
+}
+
 Shader::Shader()
 {
     shaderID = 0;
@@ -99,14 +119,17 @@ void Shader::CompileShader(const char* vertexCode, const char* fragmentCode)
         printf("Error validating program: '%s'\n", eLog);
         //return;
     }
+
+    Vosgi::UniformBlocks::BindProgram(shaderID);
 }
 
 GLuint Shader::GetUniformLocation(const char* name)
 {
-    if (IsCached(name)) return uniformLocations[name];
+    const auto it = uniformLocations.find(name);
+    if (it != uniformLocations.end()) return it->second;
 
     GLuint location = glGetUniformLocation(shaderID, name);
-    uniformLocations[name] = location;
+    uniformLocations.emplace(name, location);
     return location;
 }
 
@@ -150,11 +173,18 @@ void Shader::SetMat4(const char* name, glm::mat4 value)
     glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
 }
 
+void Shader::SetAffine(const char* name, const Vosgi::Affine& value)
+{
+    // Rows are stored contiguously, so GL transposes them into the mat4x3 columns
+    glUniformMatrix4x3fv(GetUniformLocation(name), 1, GL_TRUE, value.Data());
+}
+
 void Shader::Clear()
 {
     if (shaderID == 0) return;
     glDeleteProgram(shaderID);
     shaderID = 0;
+    uniformLocations.clear();
 }
 
 void Shader::AddShader(GLuint theProgram, const char* shaderCode, GLenum shaderType)
@@ -195,64 +225,40 @@ std::string Shader::GetAbsolutePath(const char* fileLocation)
 
 void Shader::SetGlobalBool(const char* name, bool value)
 {
-    for (auto& shader : shaders)
-    {
-        shader->SetBool(name, value);
-    }
+    ForEachProgram(shaders, [&](Shader& shader) { shader.SetBool(name, value); });
 }
 
 void Shader::SetGlobalInt(const char* name, int value)
 {
-    for (auto& shader : shaders)
-    {
-        shader->SetInt(name, value);
-    }
+    ForEachProgram(shaders, [&](Shader& shader) { shader.SetInt(name, value); });
 }
 
 void Shader::SetGlobalFloat(const char* name, float value)
 {
-    for (auto& shader : shaders)
-    {
-        shader->SetFloat(name, value);
-    }
+    ForEachProgram(shaders, [&](Shader& shader) { shader.SetFloat(name, value); });
 }
 
 void Shader::SetGlobalVec3(const char* name, glm::vec3 value)
 {
-    for (auto& shader : shaders)
-    {
-        shader->SetVec3(name, value);
-    }
+    ForEachProgram(shaders, [&](Shader& shader) { shader.SetVec3(name, value); });
 }
 
 void Shader::SetGlobalVec3(const char* name, float x, float y, float z)
 {
-    for (auto& shader : shaders)
-    {
-        shader->SetVec3(name, x, y, z);
-    }
+    ForEachProgram(shaders, [&](Shader& shader) { shader.SetVec3(name, x, y, z); });
 }
 
 void Shader::SetGlobalVec4(const char* name, glm::vec4 value)
 {
-    for (auto& shader : shaders)
-    {
-        shader->SetVec4(name, value);
-    }
+    ForEachProgram(shaders, [&](Shader& shader) { shader.SetVec4(name, value); });
 }
 
 void Shader::SetGlobalVec4(const char* name, float x, float y, float z, float w)
 {
-    for (auto& shader : shaders)
-    {
-        shader->SetVec4(name, x, y, z, w);
-    }
+    ForEachProgram(shaders, [&](Shader& shader) { shader.SetVec4(name, x, y, z, w); });
 }
 
 void Shader::SetGlobalMat4(const char* name, glm::mat4 value)
 {
-    for (auto& shader : shaders)
-    {
-        shader->SetMat4(name, value);
-    }
+    ForEachProgram(shaders, [&](Shader& shader) { shader.SetMat4(name, value); });
 }
@@ -57,7 +57,7 @@ void SpotLight::Draw(const Frustum &frustum, Shader &shader, unsigned int &displ
     shader.SetFloat((str + "base.base.ambientIntensity").c_str(), ambientIntensity);
     shader.SetFloat((str + "base.base.diffuseIntensity").c_str(), diffuseIntensity);
 
-    shader.SetVec3((str + "base.position").c_str(), transform->position);
+    shader.SetVec3((str + "base.position").c_str(), transform->GetWorldPosition());
     shader.SetFloat((str + "base.constant").c_str(), constant);
     shader.SetFloat((str + "base.linear").c_str(), linear);
     shader.SetFloat((str + "base.quadratic").c_str(), quadratic);
@@ -0,0 +1,179 @@
+#include "../Public/StreamBuffer.h"
+
+#include <algorithm>
+
+#include "../Public/Profiler.h"
+
+namespace Vosgi
+{
+    namespace
+    {
+        constexpr GLbitfield PersistentFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    }
+
+    StreamBuffer::StreamBuffer(size_t regionSize)
+        : regionSize(regionSize)
+    {
+    }
+
+    StreamBuffer::~StreamBuffer()
+    {
+        Flush();
+        for (GLsync& fence : fences)
+        {
+            if (fence) glDeleteSync(fence);
+        }
+        for (auto& [old, frames] : retired)
+        {
+            glDeleteBuffers(1, &old);
+        }
+        if (buffer != 0) glDeleteBuffers(1, &buffer);
+    }
+
+    StreamBuffer& StreamBuffer::Main()
+    {
+        // Never destroyed, the context is gone by the time statics are
+        static StreamBuffer* stream = new StreamBuffer(4 * 1024 * 1024);
+        return *stream;
+    }
+
+    size_t StreamBuffer::GetUniformAlignment()
+    {
+        static GLint alignment = 0;
+        if (alignment == 0) glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        return static_cast<size_t>(alignment);
+    }
+
+    void StreamBuffer::BeginFrame()
+    {
+        head = 0;
+
+        if (buffer != 0 && persistent)
+        {
+            region = (region + 1) % RegionCount;
+            if (GLsync& fence = fences[region])
+            {
+                if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+                {
+                    Profiler::Scope scope("Stream Buffer Wait");
+                    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+                }
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+        }
+
+        // Replaced during the frame whose fence was just waited for
+        for (size_t i = 0; i < retired.size();)
+        {
+            if (--retired[i].second == 0)
+            {
+                glDeleteBuffers(1, &retired[i].first);
+                retired.erase(retired.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        if (buffer != 0 && !persistent)
+        {
+            // Fresh storage, the draws of the previous frame keep the old one
+            Flush();
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+    }
+
+    void StreamBuffer::EndFrame()
+    {
+        Flush();
+        if (!persistent || buffer == 0) return;
+
+        if (fences[region]) glDeleteSync(fences[region]);
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    StreamBuffer::Allocation StreamBuffer::Allocate(size_t size, size_t alignment)
+    {
+        if (buffer == 0) Create(regionSize);
+
+        // Aligned in the buffer, regions do not start at a multiple of every alignment
+        size_t base = persistent ? region * regionSize : 0;
+        size_t offset = ((base + head + alignment - 1) & ~(alignment - 1)) - base;
+        if (offset + size > regionSize)
+        {
+            Create(std::max(regionSize * 2, size + alignment));
+            base = persistent ? region * regionSize : 0;
+            offset = ((base + alignment - 1) & ~(alignment - 1)) - base;
+        }
+
+        if (!mapped) Map(base + offset);
+        head = offset + size;
+
+        Allocation allocation;
+        allocation.data = mapped ? mapped + (base + offset - mappedOffset) : nullptr;
+        allocation.buffer = buffer;
+        allocation.offset = base + offset;
+        allocation.size = size;
+        return allocation;
+    }
+
+    void StreamBuffer::Flush()
+    {
+        if (persistent || !mapped) return;
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        mapped = nullptr;
+    }
+
+    void StreamBuffer::Create(size_t newRegionSize)
+    {
+        if (buffer != 0)
+        {
+            // Earlier allocations of the frame may still be bound from it
+            Flush();
+            retired.emplace_back(buffer, RegionCount);
+        }
+
+        // The new buffer has nothing in flight
+        for (GLsync& fence : fences)
+        {
+            if (fence) glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        regionSize = newRegionSize;
+        persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+        head = 0;
+        mapped = nullptr;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        if (persistent)
+        {
+            glBufferStorage(GL_COPY_WRITE_BUFFER, regionSize * RegionCount, nullptr, PersistentFlags);
+            mapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, regionSize * RegionCount, PersistentFlags));
+            mappedOffset = 0;
+        }
+        else
+        {
+            glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    void StreamBuffer::Map(size_t offset)
+    {
+        // Past what the frame already wrote, nothing the GPU may be reading, so no need to synchronize
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        mapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, regionSize - offset,
+                                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+        mappedOffset = offset;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+} // namespace Vosgi
@@ -0,0 +1,30 @@
+#include "../Public/StringId.h"
+
+#include <unordered_map>
+
+namespace Vosgi
+{
+    namespace
+    {
+        // Function-local so literals interned during static initialization are safe
+        std::unordered_map<uint64_t, std::string>& GetStrings()
+        {
+            static std::unordered_map<uint64_t, std::string> strings;
+            return strings;
+        }
+    }
+
+    StringId StringId::Intern(std::string_view text)
+    {
+        const StringId id(text);
+        GetStrings().try_emplace(id.hash, text);
+        return id;
+    }
+
+    const char* StringId::GetString() const
+    {
+        const auto& strings = GetStrings();
+        auto it = strings.find(hash);
+        return it != strings.end() ? it->second.c_str() : "";
+    }
+} // namespace Vosgi
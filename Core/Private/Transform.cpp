@@ -3,35 +3,48 @@
 
 namespace Vosgi
 {
+    Transform::Transform()
+    {
+        m_node = TransformHierarchy::Main().Add(this);
+    }
+
     Transform::Transform(glm::vec3 pos, glm::quat rot, glm::vec3 scale)
     {
         position = pos;
         rotation = rot;
         localScale = scale;
+
+        m_node = TransformHierarchy::Main().Add(this);
     }
 
-    Transform::~Transform()
+    Transform::Transform(const Transform &other)
+        : position(other.position), localPosition(other.localPosition),
+          rotation(other.rotation), localRotation(other.localRotation),
+          localScale(other.localScale)
     {
+        // A copy gets its own root node, it is not parented like the original
+        m_node = TransformHierarchy::Main().Add(this);
     }
 
-    glm::mat4 Transform::GetLocalModelMatrix() const
+    Transform &Transform::operator=(const Transform &other)
     {
-        glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), position);
-        glm::mat4 rotationMatrix = static_cast<glm::mat4>(rotation);
-        glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), localScale);
+        position = other.position;
+        localPosition = other.localPosition;
+        rotation = other.rotation;
+        localRotation = other.localRotation;
+        localScale = other.localScale;
 
-        return translationMatrix * rotationMatrix * scaleMatrix;
+        SetDirty();
+        return *this;
     }
 
-    void Transform::ComputeModelMatrix()
+    Transform::~Transform()
     {
-        m_model = GetLocalModelMatrix();
-        m_isDirty = false;
+        TransformHierarchy::Main().Remove(m_node);
     }
 
-    void Transform::ComputeModelMatrix(glm::mat4 parentModel)
+    void Transform::SetParent(Transform *parent)
     {
-        m_model = parentModel * GetLocalModelMatrix();
-        m_isDirty = false;
+        TransformHierarchy::Main().SetParent(m_node, parent ? parent->m_node : TransformHierarchy::InvalidNode);
     }
 }
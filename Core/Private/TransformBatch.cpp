@@ -0,0 +1,156 @@
+#include "../Public/TransformBatch.h"
+
+#include "../Public/SIMD.h"
+
+namespace Vosgi
+{
+    namespace TransformBatch
+    {
+        namespace
+        {
+            // Pointers to the start of every component array
+            struct Streams
+            {
+                const float *px, *py, *pz;
+                const float *qx, *qy, *qz, *qw;
+                const float *sx, *sy, *sz;
+            };
+
+            void ComposeScalar(const Streams& s, size_t begin, size_t end, Affine* out)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const float x = s.qx[i], y = s.qy[i], z = s.qz[i], w = s.qw[i];
+                    const float xx = x * x, yy = y * y, zz = z * z;
+                    const float xy = x * y, xz = x * z, yz = y * z;
+                    const float wx = w * x, wy = w * y, wz = w * z;
+
+                    const float sx = s.sx[i], sy = s.sy[i], sz = s.sz[i];
+
+                    Affine& m = out[i];
+                    m.rows[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * sx, 2.0f * (xy - wz) * sy, 2.0f * (xz + wy) * sz, s.px[i]);
+                    m.rows[1] = glm::vec4(2.0f * (xy + wz) * sx, (1.0f - 2.0f * (xx + zz)) * sy, 2.0f * (yz - wx) * sz, s.py[i]);
+                    m.rows[2] = glm::vec4(2.0f * (xz - wy) * sx, 2.0f * (yz + wx) * sy, (1.0f - 2.0f * (xx + yy)) * sz, s.pz[i]);
+                }
+            }
+
+#if VOSGI_SIMD_X86
+            // Write one row of four consecutive matrices from its x, y, z, translation lanes
+            inline void StoreRow(Affine* out, size_t index, int row, __m128 x, __m128 y, __m128 z, __m128 t)
+            {
+                _MM_TRANSPOSE4_PS(x, y, z, t);
+                _mm_storeu_ps(&out[index + 0].rows[row].x, x);
+                _mm_storeu_ps(&out[index + 1].rows[row].x, y);
+                _mm_storeu_ps(&out[index + 2].rows[row].x, z);
+                _mm_storeu_ps(&out[index + 3].rows[row].x, t);
+            }
+
+            void ComposeSSE2(const Streams& s, size_t begin, size_t end, Affine* out)
+            {
+                const __m128 one = _mm_set1_ps(1.0f);
+
+                size_t i = begin;
+                for (; i + 4 <= end; i += 4)
+                {
+                    const __m128 x = _mm_loadu_ps(s.qx + i), y = _mm_loadu_ps(s.qy + i);
+                    const __m128 z = _mm_loadu_ps(s.qz + i), w = _mm_loadu_ps(s.qw + i);
+                    const __m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+
+                    const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+                    const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+                    const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+                    const __m128 sx = _mm_loadu_ps(s.sx + i), sy = _mm_loadu_ps(s.sy + i), sz = _mm_loadu_ps(s.sz + i);
+
+                    StoreRow(out, i, 0,
+                             _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+                             _mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+                             _mm_mul_ps(_mm_add_ps(xz, wy), sz),
+                             _mm_loadu_ps(s.px + i));
+                    StoreRow(out, i, 1,
+                             _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+                             _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+                             _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+                             _mm_loadu_ps(s.py + i));
+                    StoreRow(out, i, 2,
+                             _mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+                             _mm_mul_ps(_mm_add_ps(yz, wx), sy),
+                             _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz),
+                             _mm_loadu_ps(s.pz + i));
+                }
+
+                ComposeScalar(s, i, end, out);
+            }
+
+            VOSGI_TARGET_AVX2 inline void StoreRow8(Affine* out, size_t index, int row, __m256 x, __m256 y, __m256 z, __m256 t)
+            {
+                StoreRow(out, index, row, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y),
+                         _mm256_castps256_ps128(z), _mm256_castps256_ps128(t));
+                StoreRow(out, index + 4, row, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1),
+                         _mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(t, 1));
+            }
+
+            VOSGI_TARGET_AVX2 void ComposeAVX2(const Streams& s, size_t begin, size_t end, Affine* out)
+            {
+                const __m256 one = _mm256_set1_ps(1.0f);
+
+                size_t i = begin;
+                for (; i + 8 <= end; i += 8)
+                {
+                    const __m256 x = _mm256_loadu_ps(s.qx + i), y = _mm256_loadu_ps(s.qy + i);
+                    const __m256 z = _mm256_loadu_ps(s.qz + i), w = _mm256_loadu_ps(s.qw + i);
+                    const __m256 x2 = _mm256_add_ps(x, x), y2 = _mm256_add_ps(y, y), z2 = _mm256_add_ps(z, z);
+
+                    const __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+                    const __m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+
+                    const __m256 sx = _mm256_loadu_ps(s.sx + i), sy = _mm256_loadu_ps(s.sy + i), sz = _mm256_loadu_ps(s.sz + i);
+
+                    // w * 2v products folded into the sums with fused multiply-adds
+                    StoreRow8(out, i, 0,
+                              _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+                              _mm256_mul_ps(_mm256_fnmadd_ps(w, z2, xy), sy),
+                              _mm256_mul_ps(_mm256_fmadd_ps(w, y2, xz), sz),
+                              _mm256_loadu_ps(s.px + i));
+                    StoreRow8(out, i, 1,
+                              _mm256_mul_ps(_mm256_fmadd_ps(w, z2, xy), sx),
+                              _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+                              _mm256_mul_ps(_mm256_fnmadd_ps(w, x2, yz), sz),
+                              _mm256_loadu_ps(s.py + i));
+                    StoreRow8(out, i, 2,
+                              _mm256_mul_ps(_mm256_fnmadd_ps(w, y2, xz), sx),
+                              _mm256_mul_ps(_mm256_fmadd_ps(w, x2, yz), sy),
+                              _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz),
+                              _mm256_loadu_ps(s.pz + i));
+                }
+
+                ComposeSSE2(s, i, end, out);
+            }
+#endif
+        }
+
+        void ComposeTRS(const TRSArrays& trs, size_t begin, size_t end, Affine* out)
+        {
+            const Streams streams{
+                trs.positionX.data(), trs.positionY.data(), trs.positionZ.data(),
+                trs.rotationX.data(), trs.rotationY.data(), trs.rotationZ.data(), trs.rotationW.data(),
+                trs.scaleX.data(), trs.scaleY.data(), trs.scaleZ.data(),
+            };
+
+            switch (SIMD::GetLevel())
+            {
+#if VOSGI_SIMD_X86
+            case SIMD::Level::AVX2:
+                ComposeAVX2(streams, begin, end, out);
+                break;
+            case SIMD::Level::SSE2:
+                ComposeSSE2(streams, begin, end, out);
+                break;
+#endif
+            default:
+                ComposeScalar(streams, begin, end, out);
+                break;
+            }
+        }
+    } // namespace TransformBatch
+} // namespace Vosgi
@@ -0,0 +1,398 @@
+#include "../Public/TransformHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "../Public/Transform.h"
+
+namespace Vosgi
+{
+    TransformHierarchy& TransformHierarchy::Main()
+    {
+        static TransformHierarchy hierarchy;
+        return hierarchy;
+    }
+
+    TransformHierarchy::NodeIndex TransformHierarchy::Add(Transform* owner)
+    {
+        // Roots never break the parent-first order, so any hole or the end will do
+        if (!m_free.empty())
+        {
+            const NodeIndex node = m_free.back();
+            m_free.pop_back();
+
+            m_parent[node] = InvalidNode;
+            m_depth[node] = 0;
+            m_localTRS.ForEachArray([node](std::vector<float>& values) { values[node] = 0.0f; });
+            m_local[node] = Affine();
+            m_world[node] = Affine();
+            m_decomposition[node] = Decomposition();
+            // The node may still be listed in m_moved, versions keep counting for the caches keyed on them
+            m_flags[node] = FlagDirty | (m_flags[node] & FlagMoved);
+            m_childCount[node] = 0;
+            m_owner[node] = owner;
+            return node;
+        }
+
+        const auto node = static_cast<NodeIndex>(m_owner.size());
+
+        m_parent.push_back(InvalidNode);
+        m_depth.push_back(0);
+        m_localTRS.ForEachArray([](std::vector<float>& values) { values.push_back(0.0f); });
+        m_local.push_back(Affine());
+        m_world.push_back(Affine());
+        m_decomposition.push_back(Decomposition());
+        m_flags.push_back(FlagDirty);
+        m_version.push_back(0);
+        m_childCount.push_back(0);
+        m_owner.push_back(owner);
+
+        return node;
+    }
+
+    void TransformHierarchy::Remove(NodeIndex node)
+    {
+        if (node == InvalidNode) return;
+
+        const NodeIndex parent = m_parent[node];
+        if (parent != InvalidNode) --m_childCount[parent];
+
+        // Children are made roots by the next sweep, the slot is reused after it
+        m_parent[node] = InvalidNode;
+        m_flags[node] = FlagDead | (m_flags[node] & FlagMoved);
+        m_owner[node] = nullptr;
+        m_pendingFree.push_back(node);
+    }
+
+    void TransformHierarchy::SetParent(NodeIndex node, NodeIndex parent)
+    {
+        // Refuse to create a cycle
+        for (NodeIndex ancestor = parent; ancestor != InvalidNode; ancestor = m_parent[ancestor])
+        {
+            if (ancestor == node) return;
+        }
+
+        const NodeIndex previous = m_parent[node];
+        if (previous == parent) return;
+
+        if (previous != InvalidNode) --m_childCount[previous];
+        if (parent != InvalidNode) ++m_childCount[parent];
+
+        m_parent[node] = parent;
+        m_flags[node] |= FlagDirty;
+
+        // A root, or a parent stored before the node, keeps the parent-first order
+        if (parent == InvalidNode || parent < node) return;
+
+        Relocate(node);
+    }
+
+    void TransformHierarchy::Relocate(NodeIndex node)
+    {
+        const auto count = static_cast<NodeIndex>(m_owner.size());
+        m_remap.resize(count, InvalidNode);
+
+        // Descendants follow the node, collect them until every child is found
+        m_chain.push_back(node);
+        m_remap[node] = node;
+        uint32_t missing = m_childCount[node];
+        for (NodeIndex i = node + 1; i < count && missing > 0; ++i)
+        {
+            const NodeIndex parent = m_parent[i];
+            if (parent == InvalidNode || m_remap[parent] == InvalidNode) continue;
+
+            m_chain.push_back(i);
+            missing += m_childCount[i] - 1;
+            m_remap[i] = i;
+        }
+
+        // Append them in the same order, so every parent still comes first
+        NodeIndex moved = count;
+        for (NodeIndex source : m_chain)
+        {
+            m_remap[source] = moved;
+
+            const NodeIndex parent = m_parent[source];
+            m_parent.push_back(source == node ? parent : m_remap[parent]);
+            m_depth.push_back(0);
+            m_localTRS.ForEachArray([source](std::vector<float>& values) { values.push_back(values[source]); });
+            m_local.push_back(m_local[source]);
+            m_world.push_back(m_world[source]);
+            m_decomposition.push_back(m_decomposition[source]);
+            m_flags.push_back((m_flags[source] & ~FlagMoved) | FlagDirty);
+            m_version.push_back(m_version[source]);
+            m_childCount.push_back(m_childCount[source]);
+            m_owner.push_back(m_owner[source]);
+            m_owner[moved]->m_node = moved;
+            ++moved;
+
+            // The old slot keeps no children, they moved along
+            m_parent[source] = InvalidNode;
+            m_flags[source] = FlagDead | (m_flags[source] & FlagMoved);
+            m_owner[source] = nullptr;
+            m_pendingFree.push_back(source);
+        }
+
+        for (NodeIndex source : m_chain) m_remap[source] = InvalidNode;
+        m_chain.clear();
+    }
+
+    const TransformHierarchy::Decomposition& TransformHierarchy::GetDecomposition(NodeIndex node)
+    {
+        Decomposition& decomposition = m_decomposition[node];
+        if (m_flags[node] & FlagDecomposed) return decomposition;
+
+        const Affine& world = m_world[node];
+        const glm::vec3 x = world.GetAxis(0), y = world.GetAxis(1), z = world.GetAxis(2);
+        decomposition.position = world.GetTranslation();
+        decomposition.scale = glm::vec3(glm::length(x), glm::length(y), glm::length(z));
+
+        // A zero scale leaves no direction to recover, keep the previous axes
+        if (decomposition.scale.x > 0.0f) decomposition.right = x / decomposition.scale.x;
+        if (decomposition.scale.y > 0.0f) decomposition.up = y / decomposition.scale.y;
+        if (decomposition.scale.z > 0.0f) decomposition.forward = z / decomposition.scale.z;
+
+        // A mirrored basis is a negative scale, not a rotation
+        if (glm::dot(glm::cross(decomposition.right, decomposition.up), decomposition.forward) < 0.0f)
+        {
+            decomposition.scale.x = -decomposition.scale.x;
+            decomposition.right = -decomposition.right;
+        }
+
+        decomposition.rotation = RotationFromBasis(decomposition.right, decomposition.up, decomposition.forward);
+
+        m_flags[node] |= FlagDecomposed;
+        return decomposition;
+    }
+
+    Quaternion TransformHierarchy::RotationFromBasis(const glm::vec3& right, const glm::vec3& up, const glm::vec3& forward)
+    {
+        // Branch on the largest diagonal term to keep the square root well conditioned
+        const float trace = right.x + up.y + forward.z;
+        if (trace > 0.0f)
+        {
+            const float s = 0.5f / std::sqrt(trace + 1.0f);
+            return Quaternion((up.z - forward.y) * s, (forward.x - right.z) * s, (right.y - up.x) * s, 0.25f / s);
+        }
+        if (right.x > up.y && right.x > forward.z)
+        {
+            const float s = 0.5f / std::sqrt(1.0f + right.x - up.y - forward.z);
+            return Quaternion(0.25f / s, (up.x + right.y) * s, (forward.x + right.z) * s, (up.z - forward.y) * s);
+        }
+        if (up.y > forward.z)
+        {
+            const float s = 0.5f / std::sqrt(1.0f + up.y - right.x - forward.z);
+            return Quaternion((up.x + right.y) * s, 0.25f / s, (forward.y + up.z) * s, (forward.x - right.z) * s);
+        }
+        const float s = 0.5f / std::sqrt(1.0f + forward.z - right.x - up.y);
+        return Quaternion((forward.x + right.z) * s, (forward.y + up.z) * s, 0.25f / s, (right.y - up.x) * s);
+    }
+
+    void TransformHierarchy::Update()
+    {
+        // Holes are reused, but compact them once they outnumber the live nodes
+        if (m_free.size() + m_pendingFree.size() > GetNodeCount() + 1024)
+        {
+            Sort();
+        }
+
+        ComposeDirtyLocals();
+
+        const auto count = static_cast<NodeIndex>(m_owner.size());
+        for (NodeIndex i = 0; i < count; ++i)
+        {
+            uint8_t flags = m_flags[i];
+            NodeIndex parent = m_parent[i];
+            bool parentChanged = false;
+            if (parent != InvalidNode)
+            {
+                // Children of removed nodes become roots
+                if (m_flags[parent] & FlagDead)
+                {
+                    m_parent[i] = parent = InvalidNode;
+                    parentChanged = true;
+                }
+                else
+                {
+                    parentChanged = (m_flags[parent] & FlagChanged) != 0;
+                }
+            }
+
+            if (!(flags & FlagDirty) && !parentChanged)
+            {
+                m_flags[i] = flags & ~FlagChanged;
+                continue;
+            }
+
+            m_world[i] = parent != InvalidNode ? m_world[parent] * m_local[i] : m_local[i];
+            ++m_version[i];
+
+            if (!(flags & FlagMoved)) m_moved.push_back(i);
+            m_flags[i] = (flags & ~(FlagDirty | FlagDecomposed)) | FlagChanged | FlagMoved;
+        }
+
+        // No child points at the removed nodes anymore
+        if (!m_pendingFree.empty())
+        {
+            m_free.insert(m_free.end(), m_pendingFree.begin(), m_pendingFree.end());
+            m_pendingFree.clear();
+            std::sort(m_free.begin(), m_free.end(), std::greater<NodeIndex>());
+        }
+    }
+
+    void TransformHierarchy::ComposeDirtyLocals()
+    {
+        const size_t count = m_owner.size();
+        size_t runBegin = count;
+
+        for (size_t i = 0; i <= count; ++i)
+        {
+            if (i < count && (m_flags[i] & FlagDirty))
+            {
+                // Read back the authored values only for the nodes that changed them
+                const Transform* owner = m_owner[i];
+                m_localTRS.positionX[i] = owner->position.x;
+                m_localTRS.positionY[i] = owner->position.y;
+                m_localTRS.positionZ[i] = owner->position.z;
+                m_localTRS.rotationX[i] = owner->rotation.x;
+                m_localTRS.rotationY[i] = owner->rotation.y;
+                m_localTRS.rotationZ[i] = owner->rotation.z;
+                m_localTRS.rotationW[i] = owner->rotation.w;
+                m_localTRS.scaleX[i] = owner->localScale.x;
+                m_localTRS.scaleY[i] = owner->localScale.y;
+                m_localTRS.scaleZ[i] = owner->localScale.z;
+
+                if (runBegin == count) runBegin = i;
+                continue;
+            }
+
+            // Compose each contiguous run of dirty nodes in one batch
+            if (runBegin != count)
+            {
+                // Authored rotations drift away from unit length as they are accumulated
+                const QuaternionStream rotation{m_localTRS.rotationX.data() + runBegin, m_localTRS.rotationY.data() + runBegin,
+                                                m_localTRS.rotationZ.data() + runBegin, m_localTRS.rotationW.data() + runBegin};
+                QuaternionBatch::Normalize(rotation, rotation, i - runBegin);
+
+                TransformBatch::ComposeTRS(m_localTRS, runBegin, i, m_local.data());
+                runBegin = count;
+            }
+        }
+    }
+
+    template <typename T>
+    void TransformHierarchy::ApplyOrder(std::vector<T>& values, size_t liveCount)
+    {
+        // Follow the cycles of the permutation in place, m_order[i] is the node that goes to i
+        std::fill(m_placed.begin(), m_placed.end(), 0);
+        for (size_t start = 0; start < values.size(); ++start)
+        {
+            if (m_placed[start]) continue;
+
+            T first = values[start];
+            size_t i = start;
+            while (true)
+            {
+                m_placed[i] = 1;
+                const auto source = static_cast<size_t>(m_order[i]);
+                if (source == start)
+                {
+                    values[i] = first;
+                    break;
+                }
+                values[i] = values[source];
+                i = source;
+            }
+        }
+        values.resize(liveCount);
+    }
+
+    void TransformHierarchy::Sort()
+    {
+        const auto count = static_cast<NodeIndex>(m_owner.size());
+        constexpr uint32_t unknownDepth = std::numeric_limits<uint32_t>::max();
+
+        // Children of removed nodes become roots
+        for (NodeIndex i = 0; i < count; ++i)
+        {
+            const NodeIndex parent = m_parent[i];
+            if (parent != InvalidNode && (m_flags[parent] & FlagDead))
+            {
+                m_parent[i] = InvalidNode;
+                m_flags[i] |= FlagDirty;
+            }
+        }
+
+        // Resolve depths by walking up to the first node with a known depth
+        std::fill(m_depth.begin(), m_depth.end(), unknownDepth);
+        uint32_t maxDepth = 0;
+        for (NodeIndex i = 0; i < count; ++i)
+        {
+            NodeIndex node = i;
+            while (node != InvalidNode && m_depth[node] == unknownDepth)
+            {
+                m_chain.push_back(node);
+                node = m_parent[node];
+            }
+
+            uint32_t depth = node == InvalidNode ? 0 : m_depth[node] + 1;
+            for (auto it = m_chain.rbegin(); it != m_chain.rend(); ++it)
+            {
+                m_depth[*it] = depth++;
+            }
+            m_chain.clear();
+            maxDepth = std::max(maxDepth, m_depth[i]);
+        }
+
+        // Counting sort of the live nodes by depth, keeping siblings in their order, dead nodes last
+        m_depthStart.assign(maxDepth + 2, 0);
+        size_t liveCount = 0;
+        for (NodeIndex i = 0; i < count; ++i)
+        {
+            if (m_flags[i] & FlagDead) continue;
+            ++m_depthStart[m_depth[i] + 1];
+            ++liveCount;
+        }
+        for (uint32_t depth = 1; depth < m_depthStart.size(); ++depth)
+        {
+            m_depthStart[depth] += m_depthStart[depth - 1];
+        }
+
+        m_order.resize(count);
+        m_remap.assign(count, InvalidNode);
+        size_t dead = liveCount;
+        for (NodeIndex i = 0; i < count; ++i)
+        {
+            const size_t position = (m_flags[i] & FlagDead) ? dead++ : m_depthStart[m_depth[i]]++;
+            m_order[position] = i;
+            if (position < liveCount) m_remap[i] = static_cast<NodeIndex>(position);
+        }
+
+        m_placed.resize(count);
+        ApplyOrder(m_parent, liveCount);
+        ApplyOrder(m_depth, liveCount);
+        m_localTRS.ForEachArray([this, liveCount](std::vector<float>& values) { ApplyOrder(values, liveCount); });
+        ApplyOrder(m_local, liveCount);
+        ApplyOrder(m_world, liveCount);
+        ApplyOrder(m_decomposition, liveCount);
+        ApplyOrder(m_flags, liveCount);
+        ApplyOrder(m_version, liveCount);
+        ApplyOrder(m_childCount, liveCount);
+        ApplyOrder(m_owner, liveCount);
+
+        m_moved.clear();
+        for (NodeIndex i = 0; i < static_cast<NodeIndex>(liveCount); ++i)
+        {
+            if (m_parent[i] != InvalidNode) m_parent[i] = m_remap[m_parent[i]];
+            m_owner[i]->m_node = i;
+            if (m_flags[i] & FlagMoved) m_moved.push_back(i);
+        }
+
+        // The holes are gone
+        std::fill(m_remap.begin(), m_remap.end(), InvalidNode);
+        m_free.clear();
+        m_pendingFree.clear();
+    }
+} // namespace Vosgi
@@ -0,0 +1,41 @@
+#include "../Public/UniformBlocks.h"
+
+#include <cstring>
+
+#include "../Public/StreamBuffer.h"
+
+namespace Vosgi
+{
+    namespace UniformBlocks
+    {
+        namespace
+        {
+            // Valid until the stream buffer region comes around again, long after the frame is drawn
+            void Upload(Binding binding, const void* data, size_t size)
+            {
+                StreamBuffer& stream = StreamBuffer::Main();
+                const StreamBuffer::Allocation allocation = stream.Allocate(size, StreamBuffer::GetUniformAlignment());
+                std::memcpy(allocation.data, data, size);
+                stream.Flush();
+
+                glBindBufferRange(GL_UNIFORM_BUFFER, binding, allocation.buffer, static_cast<GLintptr>(allocation.offset), static_cast<GLsizeiptr>(size));
+            }
+
+            void BindBlock(GLuint program, const char* name, Binding binding)
+            {
+                const GLuint index = glGetUniformBlockIndex(program, name);
+                if (index != GL_INVALID_INDEX) glUniformBlockBinding(program, index, binding);
+            }
+        }
+
+        void SetView(const ViewData& data)
+        {
+            Upload(ViewBinding, &data, sizeof(data));
+        }
+
+        void BindProgram(GLuint program)
+        {
+            BindBlock(program, ViewBlockName, ViewBinding);
+        }
+    }
+} // namespace Vosgi
@@ -9,6 +9,10 @@
 #include <imgui/imgui_impl_glfw.h>
 #include <imgui/imgui_impl_opengl3.h>
 
+#include "../Public/Profiler.h"
+#include "../Public/SIMD.h"
+#include "../Public/StreamBuffer.h"
+
 namespace Vosgi
 {
     Window_OpenGL::Window_OpenGL(WindowHandle *windowHandle, GLint width, GLint height)
@@ -136,10 +140,17 @@ namespace Vosgi
             unsigned int displayCount = 0;
             unsigned int drawCount = 0;
             unsigned int entityCount = 0;
+            Profiler::BeginFrame();
+
+            // Per-frame data is written into the region the GPU finished with
+            StreamBuffer::Main().BeginFrame();
 
             // Get + Handle User Input
             PollEvents();
 
+            // Simulate the frame before anything is drawn
+            windowHandle->Update(deltaTime);
+
             // Clear the window
             glClearColor(1.f, 1.f, 1.f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -164,6 +175,25 @@ namespace Vosgi
 
             ImGui::PlotLines(buffer, fps_values, IM_ARRAYSIZE(fps_values), fps_values_offset, NULL, 0.0f, 100.0f, ImVec2(0, 120));
 
+            // Samples reported by the engine systems this frame
+            for (const auto &sample : Profiler::GetSamples())
+            {
+                if (sample.isTimer)
+                    ImGui::Text("%s: %.3fms", sample.name, sample.milliseconds);
+                else if (sample.isValue)
+                    ImGui::Text("%s: %.2f", sample.name, sample.value);
+                else
+                    ImGui::Text("%s: %u", sample.name, sample.count);
+            }
+
+            // Batch kernel level, can be lowered to compare against the scalar path
+            int simdLevel = static_cast<int>(SIMD::GetLevel());
+            const char *simdLevels[] = {"Scalar", "SSE2", "AVX2"};
+            if (ImGui::Combo("SIMD", &simdLevel, simdLevels, static_cast<int>(SIMD::GetSupportedLevel()) + 1))
+            {
+                SIMD::SetLevel(static_cast<SIMD::Level>(simdLevel));
+            }
+
             // Set new fps
             ImGui::SliderInt("Max FPS", &maxFPS, 1, 144);
             desiredFrameTime = 1.0 / maxFPS;
@@ -175,12 +205,12 @@ namespace Vosgi
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
+            StreamBuffer::Main().EndFrame();
             SwapBuffers();
 
         } while (!glfwWindowShouldClose(window));
 
-        // Terminate window
-        Terminate();
+        // The owner terminates the window once it released its GL resources
     }
 
     void Window_OpenGL::SwapBuffers()
@@ -195,13 +225,20 @@ namespace Vosgi
 
     void Window_OpenGL::Terminate()
     {
+        // Also called by the destructor, after the owner terminated the window
+        if (!window) return;
+
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
         glfwDestroyWindow(window);
         glfwTerminate();
+        window = nullptr;
+    }
 
-        exit(0);
+    void Window_OpenGL::Close()
+    {
+        glfwSetWindowShouldClose(window, GL_TRUE);
     }
 
     void Window_OpenGL::SetWindowLabel(const char *label)
@@ -0,0 +1,172 @@
+#ifndef __AABB_TREE_H__
+#define __AABB_TREE_H__
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Culling.h"
+#include "Frustum.h"
+
+namespace Vosgi
+{
+    /**
+     * \brief Dynamic bounding volume hierarchy of fattened world-space boxes.
+     *
+     * Each proxy is stored with a box enlarged by a margin, so small moves
+     * stay inside it and leave the tree untouched. Leaves are inserted where
+     * they grow the surface area the least, and every insertion or removal
+     * rotates the ancestors to keep the tree balanced.
+     *
+     * Frustum queries reject whole subtrees and report every leaf below a
+     * node that is fully inside without testing it. That walk is bound by
+     * memory latency, so once a good part of the proxies is visible, the
+     * fattened boxes kept side by side in leaf arrays are tested instead
+     * with the SIMD Culling::FrustumCull.
+     */
+    class AABBTree
+    {
+    public:
+        using ProxyId = int32_t;
+        static constexpr ProxyId NullProxy = -1;
+
+        AABBTree();
+        AABBTree(const AABBTree&) = delete;
+        AABBTree& operator=(const AABBTree&) = delete;
+
+        /**
+         * \brief Add a box to the tree
+         * \param min Lower corner of the tight box
+         * \param max Upper corner of the tight box
+         * \param userData Returned by the queries for this proxy
+         * \return The proxy, stable until it is destroyed
+         */
+        ProxyId CreateProxy(const glm::vec3& min, const glm::vec3& max, void* userData);
+
+        void DestroyProxy(ProxyId proxy);
+
+        /**
+         * \brief Update the box of a proxy
+         * \return True if the box left its fattened box and the leaf was reinserted
+         */
+        bool MoveProxy(ProxyId proxy, const glm::vec3& min, const glm::vec3& max);
+
+        /**
+         * \brief Reinsert a few leaves, cycling through the tree across calls.
+         * Leaves inserted early were placed for a tree that no longer exists,
+         * so reinserting them over time keeps queries cheap.
+         * \param iterations The number of leaves to reinsert
+         */
+        void Rebalance(uint32_t iterations);
+
+        /**
+         * \brief Collect the user data of every proxy whose fattened box touches the frustum.
+         * Each node remembers the plane that last rejected it, to test it first next time.
+         * Scans every leaf instead when the previous query saw more than scanFraction of them.
+         * \return The box and plane tests performed
+         */
+        Culling::PlaneStats QueryFrustum(const Frustum& frustum, std::vector<void*>& out);
+
+        /** \brief QueryFrustum for a tree whose user data all point to a T, appended to out */
+        template <typename T>
+        Culling::PlaneStats QueryFrustum(const Frustum& frustum, std::vector<T*>& out)
+        {
+            queryResults.clear();
+            const Culling::PlaneStats stats = QueryFrustum(frustum, queryResults);
+
+            out.reserve(out.size() + queryResults.size());
+            for (void* userData : queryResults) out.push_back(static_cast<T*>(userData));
+            return stats;
+        }
+
+        void* GetUserData(ProxyId proxy) const { return nodes[proxy].userData; }
+
+        /** \brief Changes whenever a proxy is added, removed or reinserted, to reuse query results */
+        uint32_t GetVersion() const { return version; }
+
+        /** \brief Changes whenever a proxy is added or removed, but not when one moves */
+        uint32_t GetMembershipVersion() const { return membershipVersion; }
+
+        int32_t GetHeight() const { return root == NullProxy ? 0 : nodes[root].height; }
+        uint32_t GetProxyCount() const { return proxyCount; }
+
+        /** \brief How much fattened boxes extend past the tight ones, in world units */
+        float margin = 0.2f;
+
+        /** \brief Visible part of the proxies above which a query scans every leaf, above 1 to always walk the tree */
+        float scanFraction = 1.0f / 32.0f;
+
+        /** \brief The tree every Model registers its bounds into */
+        static AABBTree& Main();
+
+    private:
+        struct Node
+        {
+            glm::vec3 min = glm::vec3(0.0f);
+            glm::vec3 max = glm::vec3(0.0f);
+            void* userData = nullptr;
+
+            // Parent while in the tree, next free node while in the free list
+            int32_t parentOrNext = NullProxy;
+            int32_t child1 = NullProxy;
+            int32_t child2 = NullProxy;
+
+            // Leaves are 0, free nodes are -1
+            int32_t height = -1;
+
+            // Frustum plane that rejected the node last, see Culling::TestPlanes
+            uint8_t rejectingPlane = 0;
+
+            bool IsLeaf() const { return child1 == NullProxy; }
+        };
+
+        int32_t AllocateNode();
+        void FreeNode(int32_t node);
+
+        void InsertLeaf(int32_t leaf);
+        void RemoveLeaf(int32_t leaf);
+
+        // Rotate the subtree at node if it is imbalanced, return the new subtree root
+        int32_t Balance(int32_t node);
+
+        // Refit the boxes and heights from node up to the root, balancing on the way
+        void SyncAncestors(int32_t node);
+
+        // Copy the fattened box of a proxy into the leaf arrays
+        void StoreLeafBounds(ProxyId proxy);
+
+    private:
+        std::vector<Node> nodes;
+        int32_t root = NullProxy;
+        int32_t freeList = NullProxy;
+
+        uint32_t proxyCount = 0;
+        uint32_t version = 0;
+        uint32_t membershipVersion = 0;
+        uint32_t rebalanceCursor = 0;
+
+        // Fattened boxes and user data of the proxies, densely packed, and the position of each proxy in them
+        BoundsArrays leafBounds;
+        std::vector<void*> leafData;
+        std::vector<ProxyId> leafProxies;
+        std::vector<int32_t> leafSlots;
+
+        // Proxies the previous query returned, to choose between walking and scanning
+        size_t lastVisible = 0;
+
+        // Scratch of QueryFrustum, kept for its capacity. Each stack entry carries
+        // the planes its parent was not fully inside of
+        std::vector<std::pair<int32_t, uint8_t>> stack;
+        std::vector<int32_t> subtree;
+        VisibilityMask scanVisibility;
+
+        // Untyped results of the typed QueryFrustum, kept for their capacity
+        std::vector<void*> queryResults;
+    };
+} // namespace Vosgi
+
+#endif // !__AABB_TREE_H__
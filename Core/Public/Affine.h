@@ -0,0 +1,119 @@
+#ifndef __AFFINE_H__
+#define __AFFINE_H__
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "SIMD.h"
+
+namespace Vosgi
+{
+    /**
+     * \brief Affine transform stored as the top three rows of a 4x4 matrix.
+     *
+     * The implicit last row is (0, 0, 0, 1), so a world matrix takes 48 bytes
+     * instead of 64. Each row holds (x, y, z, translation), which is the
+     * layout glUniformMatrix4x3fv expects with transpose set to GL_TRUE for a
+     * GLSL mat4x3.
+     */
+    struct Affine
+    {
+        glm::vec4 rows[3];
+
+        /** \brief Identity */
+        Affine() : rows{glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f)} {}
+
+        Affine(const glm::vec4& row0, const glm::vec4& row1, const glm::vec4& row2) : rows{row0, row1, row2} {}
+
+        /** \brief Drop the last row of a matrix, which must be (0, 0, 0, 1) */
+        explicit Affine(const glm::mat4& matrix)
+            : rows{glm::vec4(matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0]),
+                   glm::vec4(matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1]),
+                   glm::vec4(matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2])}
+        {
+        }
+
+        bool operator==(const Affine& other) const = default;
+
+        glm::mat4 ToMat4() const
+        {
+            glm::mat4 matrix(1.0f);
+            for (int column = 0; column < 4; ++column)
+            {
+                matrix[column] = glm::vec4(rows[0][column], rows[1][column], rows[2][column], column == 3 ? 1.0f : 0.0f);
+            }
+            return matrix;
+        }
+
+        /** \brief The transformed X, Y or Z axis, including scale */
+        glm::vec3 GetAxis(int axis) const { return glm::vec3(rows[0][axis], rows[1][axis], rows[2][axis]); }
+
+        glm::vec3 GetTranslation() const { return glm::vec3(rows[0].w, rows[1].w, rows[2].w); }
+
+        glm::vec3 TransformPoint(const glm::vec3& point) const
+        {
+            const glm::vec4 p(point, 1.0f);
+            return glm::vec3(glm::dot(rows[0], p), glm::dot(rows[1], p), glm::dot(rows[2], p));
+        }
+
+        glm::vec3 TransformVector(const glm::vec3& vector) const
+        {
+            const glm::vec4 v(vector, 0.0f);
+            return glm::vec3(glm::dot(rows[0], v), glm::dot(rows[1], v), glm::dot(rows[2], v));
+        }
+
+        /** \brief Row-major floats, for upload as a transposed mat4x3 */
+        const float* Data() const { return &rows[0].x; }
+
+        /** \brief Compose, applying other first */
+        Affine operator*(const Affine& other) const
+        {
+            Affine result;
+#if VOSGI_SIMD_X86
+            const __m128 b0 = _mm_loadu_ps(&other.rows[0].x);
+            const __m128 b1 = _mm_loadu_ps(&other.rows[1].x);
+            const __m128 b2 = _mm_loadu_ps(&other.rows[2].x);
+            const __m128 translation = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+
+            for (int i = 0; i < 3; ++i)
+            {
+                const __m128 a = _mm_loadu_ps(&rows[i].x);
+                __m128 row = _mm_and_ps(a, translation);
+                row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0));
+                row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+                row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+                _mm_storeu_ps(&result.rows[i].x, row);
+            }
+#else
+            for (int i = 0; i < 3; ++i)
+            {
+                const glm::vec4& a = rows[i];
+                result.rows[i] = a.x * other.rows[0] + a.y * other.rows[1] + a.z * other.rows[2] + glm::vec4(0.0f, 0.0f, 0.0f, a.w);
+            }
+#endif
+            return result;
+        }
+
+        /** \brief Inverse transform. The linear part must not be singular. */
+        Affine Inverse() const
+        {
+            const glm::vec3 r0(rows[0]), r1(rows[1]), r2(rows[2]);
+
+            // Columns of the inverse 3x3 are the cross products of the rows over the determinant
+            const glm::vec3 c0 = glm::cross(r1, r2);
+            const glm::vec3 c1 = glm::cross(r2, r0);
+            const glm::vec3 c2 = glm::cross(r0, r1);
+            const float inverseDeterminant = 1.0f / glm::dot(r0, c0);
+
+            const glm::vec3 i0 = glm::vec3(c0.x, c1.x, c2.x) * inverseDeterminant;
+            const glm::vec3 i1 = glm::vec3(c0.y, c1.y, c2.y) * inverseDeterminant;
+            const glm::vec3 i2 = glm::vec3(c0.z, c1.z, c2.z) * inverseDeterminant;
+
+            const glm::vec3 t = GetTranslation();
+            return Affine(glm::vec4(i0, -glm::dot(i0, t)), glm::vec4(i1, -glm::dot(i1, t)), glm::vec4(i2, -glm::dot(i2, t)));
+        }
+    };
+} // namespace Vosgi
+
+#endif // !__AFFINE_H__
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -12,7 +13,6 @@
 #include "GUID.h"
 
 // Forward declaration
-class Entity;
 class Shader;
 struct Frustum;
 
@@ -21,6 +21,12 @@ struct Frustum;
  */
 namespace Vosgi
 {
+    class Entity;
+    class ComponentPoolBase;
+
+    using ComponentTypeId = uint32_t;
+    constexpr ComponentTypeId InvalidComponentType = UINT32_MAX;
+
     class Behaviour
     {
     public:
@@ -55,11 +61,18 @@ namespace Vosgi
         Observable<bool> enabled = true;
 
     public:
-        [[nodiscard]] std::string GetGUID() const { return GUID; }
+        [[nodiscard]] const GUID& GetGUID() const { return guid; }
+        [[nodiscard]] ComponentTypeId GetComponentType() const { return componentType; }
 
     private:
-        // guid
-        std::string GUID = RandomGUID(8);
+        friend class ComponentPoolBase;
+
+        // Set by the pool that allocated this behaviour
+        ComponentTypeId componentType = InvalidComponentType;
+        uint32_t poolSlot = 0;
+        uint32_t poolIndex = 0;
+
+        GUID guid = GUID::Generate();
     };
 }
 #endif // !__BEHAVIOUR_H__
\ No newline at end of file
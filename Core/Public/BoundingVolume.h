@@ -53,10 +53,10 @@ namespace Vosgi
         bool isOnFrustum(const Frustum &camFrustum, const Transform &transform) const final
         {
             // Get global scale thanks to our transform
-            const glm::vec3 globalScale = transform.GetWorldScale();
+            const glm::vec3& globalScale = transform.GetWorldScale();
 
             // Get our global center with process it with the global model matrix of our transform
-            const glm::vec3 globalCenter{transform.GetModel() * glm::vec4(center, 1.f)};
+            const glm::vec3 globalCenter = transform.GetModel().TransformPoint(center);
 
             // To wrap correctly our shape, we need the maximum scale scalar.
             const float maxScale = std::max(std::max(globalScale.x, globalScale.y), globalScale.z);
@@ -94,12 +94,13 @@ namespace Vosgi
         bool isOnFrustum(const Frustum &camFrustum, const Transform &transform) const final
         {
             // Get global scale thanks to our transform
-            const glm::vec3 globalCenter{transform.GetModel() * glm::vec4(center, 1.f)};
+            const glm::vec3 globalCenter = transform.GetModel().TransformPoint(center);
 
             // Scaled orientation
-            const glm::vec3 right = transform.GetRight() * extent;
-            const glm::vec3 up = transform.GetUp() * extent;
-            const glm::vec3 forward = transform.GetForward() * extent;
+            const glm::vec3& globalScale = transform.GetWorldScale();
+            const glm::vec3 right = transform.GetRight() * globalScale.x * extent;
+            const glm::vec3 up = transform.GetUp() * globalScale.y * extent;
+            const glm::vec3 forward = transform.GetForward() * globalScale.z * extent;
 
             const float newIi = std::abs(glm::dot(glm::vec3{1.f, 0.f, 0.f}, right)) +
                                 std::abs(glm::dot(glm::vec3{1.f, 0.f, 0.f}, up)) +
@@ -146,6 +147,9 @@ namespace Vosgi
 
         virtual ~AABB() = default;
 
+        // Test an already world-space box
+        using BoundingVolume::isOnFrustum;
+
         std::array<glm::vec3, 8> getVertice() const
         {
             std::array<glm::vec3, 8> vertice;
@@ -160,6 +164,18 @@ namespace Vosgi
             return vertice;
         }
 
+        /** \brief The box enclosing this one once transformed, its extents are |linear part| * extents */
+        [[nodiscard]] AABB GetTransformed(const Affine &matrix) const
+        {
+            glm::vec3 worldExtents;
+            for (int i = 0; i < 3; ++i)
+            {
+                const glm::vec4 &row = matrix.rows[i];
+                worldExtents[i] = std::abs(row.x) * extents.x + std::abs(row.y) * extents.y + std::abs(row.z) * extents.z;
+            }
+            return AABB(matrix.TransformPoint(center), worldExtents.x, worldExtents.y, worldExtents.z);
+        }
+
         // see https://gdbooks.gitbooks.io/3dcollisions/content/Chapter2/static_aabb_plane.html
         [[nodiscard]] bool isOnOrForwardPlane(const Plane &plane) const final
         {
@@ -173,12 +189,13 @@ namespace Vosgi
         [[nodiscard]] bool isOnFrustum(const Frustum &camFrustum, const Transform &transform) const final
         {
             // Get global scale thanks to our transform
-            const glm::vec3 globalCenter{transform.GetModel() * glm::vec4(center, 1.f)};
+            const glm::vec3 globalCenter = transform.GetModel().TransformPoint(center);
 
             // Scaled orientation
-            const glm::vec3 right = transform.GetRight() * transform.localScale.x * extents.x;
-            const glm::vec3 up = transform.GetUp() * transform.localScale.y * extents.y;
-            const glm::vec3 forward = transform.GetForward() * transform.localScale.z * extents.z;
+            const glm::vec3& globalScale = transform.GetWorldScale();
+            const glm::vec3 right = transform.GetRight() * globalScale.x * extents.x;
+            const glm::vec3 up = transform.GetUp() * globalScale.y * extents.y;
+            const glm::vec3 forward = transform.GetForward() * globalScale.z * extents.z;
 
             const float newIi = std::abs(glm::dot(glm::vec3{1.f, 0.f, 0.f}, right)) +
                                 std::abs(glm::dot(glm::vec3{1.f, 0.f, 0.f}, up)) +
@@ -205,20 +222,15 @@ namespace Vosgi
 
     static AABB generateAABB(const std::vector<Mesh *> &meshes)
     {
-        glm::vec3 minAABB = glm::vec3(std::numeric_limits<float>::max());
-        glm::vec3 maxAABB = glm::vec3(std::numeric_limits<float>::min());
+        if (meshes.empty()) return {};
+
+        // Merge the bounds each mesh computed at import
+        glm::vec3 minAABB = meshes.front()->GetBoundsMin();
+        glm::vec3 maxAABB = meshes.front()->GetBoundsMax();
         for (auto &&mesh : meshes)
         {
-            for (auto &&vertex : mesh->GetVertices())
-            {
-                minAABB.x = std::min(minAABB.x, vertex.position.x);
-                minAABB.y = std::min(minAABB.y, vertex.position.y);
-                minAABB.z = std::min(minAABB.z, vertex.position.z);
-
-                maxAABB.x = std::max(maxAABB.x, vertex.position.x);
-                maxAABB.y = std::max(maxAABB.y, vertex.position.y);
-                maxAABB.z = std::max(maxAABB.z, vertex.position.z);
-            }
+            minAABB = glm::min(minAABB, mesh->GetBoundsMin());
+            maxAABB = glm::max(maxAABB, mesh->GetBoundsMax());
         }
         return {minAABB, maxAABB };
     }
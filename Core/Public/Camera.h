@@ -7,6 +7,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Behaviour.h"
+#include "Frustum.h"
 
 class Camera : public Vosgi::Behaviour
 {
@@ -18,10 +19,10 @@ public:
     void keyControl(bool *key, float deltaTime);
     void mouseControl(GLfloat xChange, GLfloat yChange);
 
-    void Update(float deltaTime) override;
+    void Draw(const Frustum& frustum, Shader& shader, unsigned int& display, unsigned int& draw) override;
     void DrawInspector() override;
 
-    inline glm::vec3 getCameraPosition() const { return transform->position; }
+    inline glm::vec3 getCameraPosition() const { return transform->GetWorldPosition(); }
     inline glm::vec3 getCameraDirection() const { return transform->GetForward(); }
 
     // Getters
@@ -33,12 +34,15 @@ public:
 
     inline glm::mat4 calculateViewMatrix() const
     {
-        glm::vec3 pos = transform->position;
+        glm::vec3 pos = transform->GetWorldPosition();
         return glm::lookAt(pos, pos - transform->GetForward(), transform->GetUp());
     }
 
-    // Get frustum planes
-    Frustum getFrustum() const;
+    // Get frustum planes, extracted again only when the camera or the projection changed
+    const Frustum& getFrustum() const;
+
+    // Get projection * view, cached along with the frustum
+    const glm::mat4& getViewProjectionMatrix() const;
 
     inline glm::mat4 getProjectionMatrix() const { return projection; }
 
@@ -60,4 +64,14 @@ public:
     GLfloat aspectRatio = 800.0f / 600.0f;
     GLfloat nearPlane = 0.1f;
     GLfloat farPlane = 100.0f;
+
+private:
+    void updateFrustum() const;
+
+    // What the cached frustum was extracted from
+    mutable Frustum frustum = Frustum();
+    mutable glm::mat4 viewProjection = glm::mat4(1.0f);
+    mutable Vosgi::Affine frustumWorld = Vosgi::Affine();
+    mutable glm::mat4 frustumProjection = glm::mat4(1.0f);
+    mutable bool frustumValid = false;
 };
\ No newline at end of file
@@ -0,0 +1,173 @@
+#ifndef __COMPONENT_POOL_H__
+#define __COMPONENT_POOL_H__
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Behaviour.h"
+
+namespace Vosgi
+{
+    /**
+     * \brief Type-erased part of a component pool.
+     *
+     * Keeps the live behaviours of one concrete type densely packed so systems
+     * can iterate them linearly, and gives every pool a slot in a table indexed
+     * by component type id.
+     */
+    class ComponentPoolBase
+    {
+    public:
+        explicit ComponentPoolBase(ComponentTypeId typeId);
+        virtual ~ComponentPoolBase() = default;
+
+        ComponentPoolBase(const ComponentPoolBase&) = delete;
+        ComponentPoolBase& operator=(const ComponentPoolBase&) = delete;
+
+        /** \brief Destroy a behaviour allocated by this pool */
+        virtual void Destroy(Behaviour* behaviour) = 0;
+
+        /** \brief The live behaviours, densely packed */
+        const std::vector<Behaviour*>& GetBehaviours() const { return dense; }
+        ComponentTypeId GetTypeId() const { return typeId; }
+
+        /** \brief Every pool created so far, indexed by type id (entries may be null) */
+        static const std::vector<ComponentPoolBase*>& GetPools() { return pools; }
+
+        /** \brief The pool of a type id, or nullptr if no behaviour of that type was ever created */
+        static ComponentPoolBase* GetPool(ComponentTypeId typeId)
+        {
+            return typeId < pools.size() ? pools[typeId] : nullptr;
+        }
+
+        /** \brief Return a behaviour to the pool it was allocated from */
+        static void Release(Behaviour* behaviour) { pools[behaviour->componentType]->Destroy(behaviour); }
+
+        /** \brief Reserve the next component type id */
+        static ComponentTypeId NextTypeId() { return typeCount++; }
+
+    protected:
+        void Register(Behaviour* behaviour, uint32_t slot);
+        void Unregister(Behaviour* behaviour);
+
+        // Destroy every entity through the EntityPool, while this pool can still release their behaviours
+        void ReleaseEntities();
+
+        static uint32_t GetSlot(const Behaviour* behaviour) { return behaviour->poolSlot; }
+
+    protected:
+        std::vector<Behaviour*> dense = std::vector<Behaviour*>();
+
+    private:
+        ComponentTypeId typeId;
+
+        static std::vector<ComponentPoolBase*> pools;
+        static ComponentTypeId typeCount;
+    };
+
+    /** \brief The id of a component type, assigned once on first use */
+    template <typename T>
+    ComponentTypeId GetComponentTypeId()
+    {
+        static const ComponentTypeId id = ComponentPoolBase::NextTypeId();
+        return id;
+    }
+
+    /**
+     * \brief Storage for every behaviour of the concrete type T.
+     *
+     * Behaviours are constructed in fixed-size chunks so their addresses never
+     * change, and freed slots are reused before a new chunk is allocated.
+     */
+    template <typename T>
+    class ComponentPool final : public ComponentPoolBase
+    {
+        static_assert(std::is_base_of<Behaviour, T>::value, "Must be derived from Behaviour");
+
+    public:
+        static constexpr uint32_t ChunkSize = 64;
+
+        static ComponentPool& Instance()
+        {
+            static ComponentPool pool;
+            return pool;
+        }
+
+        ~ComponentPool() override
+        {
+            // Only at exit, when this pool is destroyed before the EntityPool with entities still alive
+            if (!dense.empty()) ReleaseEntities();
+        }
+
+        /** \brief Construct a new behaviour in the pool */
+        template <typename... Args>
+        T* Create(Args&&... args)
+        {
+            uint32_t slot;
+            if (!freeSlots.empty())
+            {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            else
+            {
+                slot = slotCount++;
+                if (slot / ChunkSize >= chunks.size())
+                {
+                    chunks.push_back(std::make_unique<Chunk>());
+                }
+            }
+
+            T* behaviour = new (SlotAddress(slot)) T(std::forward<Args>(args)...);
+            Register(behaviour, slot);
+            return behaviour;
+        }
+
+        void Destroy(Behaviour* behaviour) override
+        {
+            const uint32_t slot = GetSlot(behaviour);
+            Unregister(behaviour);
+            static_cast<T*>(behaviour)->~T();
+            freeSlots.push_back(slot);
+        }
+
+        /** \brief Call func on every live behaviour of the pool */
+        template <typename Func>
+        void ForEach(Func&& func)
+        {
+            // Index loop so behaviours created by func do not invalidate the iteration
+            for (size_t i = 0; i < dense.size(); ++i)
+            {
+                func(*static_cast<T*>(dense[i]));
+            }
+        }
+
+        size_t Size() const { return dense.size(); }
+
+    private:
+        ComponentPool() : ComponentPoolBase(GetComponentTypeId<T>()) {}
+
+        struct Chunk
+        {
+            alignas(T) unsigned char storage[sizeof(T) * ChunkSize];
+        };
+
+        T* SlotAddress(uint32_t slot)
+        {
+            return reinterpret_cast<T*>(chunks[slot / ChunkSize]->storage + sizeof(T) * (slot % ChunkSize));
+        }
+
+    private:
+        std::vector<std::unique_ptr<Chunk>> chunks = std::vector<std::unique_ptr<Chunk>>();
+        std::vector<uint32_t> freeSlots = std::vector<uint32_t>();
+        uint32_t slotCount = 0;
+    };
+} // namespace Vosgi
+
+#endif // !__COMPONENT_POOL_H__
@@ -0,0 +1,187 @@
+#ifndef __CULLING_H__
+#define __CULLING_H__
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+
+namespace Vosgi
+{
+    /**
+     * \brief World-space axis aligned boxes of many objects, one array per component.
+     *
+     * Laid out like TRSArrays so the culling kernels test several boxes per
+     * SIMD register against the same plane.
+     */
+    struct BoundsArrays
+    {
+        std::vector<float> centerX, centerY, centerZ;
+        std::vector<float> extentX, extentY, extentZ;
+
+        size_t Size() const { return centerX.size(); }
+
+        void Clear() { ForEachArray([](std::vector<float>& values) { values.clear(); }); }
+
+        void Add(const glm::vec3& center, const glm::vec3& extents)
+        {
+            centerX.push_back(center.x), centerY.push_back(center.y), centerZ.push_back(center.z);
+            extentX.push_back(extents.x), extentY.push_back(extents.y), extentZ.push_back(extents.z);
+        }
+
+        /** \brief Call func on every component array, to resize or reorder them together */
+        template <typename Func>
+        void ForEachArray(Func&& func)
+        {
+            func(centerX), func(centerY), func(centerZ);
+            func(extentX), func(extentY), func(extentZ);
+        }
+    };
+
+    /** \brief One bit per object, set when the object is visible */
+    using VisibilityMask = std::vector<uint32_t>;
+
+    /** \brief One bit per view for a single object, set when the view sees the object */
+    using ViewMask = uint32_t;
+
+    namespace Culling
+    {
+        /**
+         * \brief Test every box against the six planes of a frustum
+         * \param frustum The planes, with normals pointing inside
+         * \param bounds The world-space boxes to test
+         * \param visibility Resized to hold one bit per box, bit i set when box i is at least partly inside
+         * \return The number of visible boxes
+         */
+        size_t FrustumCull(const Frustum& frustum, const BoundsArrays& bounds, VisibilityMask& visibility);
+
+        /** \brief Most views MultiFrustumCull tests at once, one per bit of a ViewMask */
+        constexpr size_t MaxViews = 32;
+
+        /**
+         * \brief Test every box against several frustums in a single pass over the bounds.
+         * Each group of boxes is loaded once and tested against all the views, so a view
+         * costs its plane tests rather than another traversal. A single view is cheaper
+         * with FrustumCull, which writes a bit per box rather than a mask.
+         * \param frustums The views, at most MaxViews
+         * \param viewCount Number of frustums
+         * \param bounds The world-space boxes to test
+         * \param views Resized to hold one mask per box, bit v set when frustum v sees the box
+         * \return The number of boxes seen by at least one view
+         */
+        size_t MultiFrustumCull(const Frustum* frustums, size_t viewCount, const BoundsArrays& bounds, std::vector<ViewMask>& views);
+
+        /** \brief Bit mask selecting all six planes of a frustum, see TestPlanes */
+        constexpr uint8_t AllPlanes = (1 << 6) - 1;
+
+        /** \brief Work done by TestPlanes over a traversal */
+        struct PlaneStats
+        {
+            uint32_t boxes = 0;
+            uint32_t planes = 0;
+
+            float GetPlanesPerBox() const { return boxes ? static_cast<float>(planes) / static_cast<float>(boxes) : 0.0f; }
+        };
+
+        /**
+         * \brief Test one box against the planes of a frustum selected by a mask, for hierarchical traversals.
+         * Objects that were rejected tend to stay rejected by the same plane, so that plane is tested first.
+         * \param mask Planes to test, bits of the planes the box is fully inside of are cleared
+         * \param rejectingPlane Plane to test first, set to the plane that rejects the box
+         * \param stats Counts the box and the planes tested
+         * \return False if the box is fully outside one of the planes
+         */
+        inline bool TestPlanes(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extents, uint8_t& mask, uint8_t& rejectingPlane, PlaneStats& stats)
+        {
+            const Plane* planes[6] = {&frustum.leftFace, &frustum.rightFace, &frustum.farFace,
+                                      &frustum.nearFace, &frustum.topFace, &frustum.bottomFace};
+            ++stats.boxes;
+
+            // Returns false when the box is outside, clears the plane from the mask when fully inside
+            auto test = [&](int i) {
+                ++stats.planes;
+                const glm::vec3& normal = planes[i]->normal;
+                const float distance = planes[i]->getSignedDistanceToPlane(center);
+                const float radius = extents.x * std::abs(normal.x) + extents.y * std::abs(normal.y) + extents.z * std::abs(normal.z);
+
+                if (distance < -radius) return false;
+                if (distance >= radius) mask &= ~(1 << i);
+                return true;
+            };
+
+            const int first = rejectingPlane;
+            if ((mask & (1 << first)) && !test(first)) return false;
+
+            for (int i = 0; i < 6; ++i)
+            {
+                if (i == first || !(mask & (1 << i))) continue;
+                if (test(i)) continue;
+
+                rejectingPlane = static_cast<uint8_t>(i);
+                return false;
+            }
+            return true;
+        }
+
+        /** \brief Call func(index) for every set bit of the mask, in increasing order */
+        template <typename Func>
+        void ForEachVisible(const VisibilityMask& visibility, Func&& func)
+        {
+            for (size_t word = 0; word < visibility.size(); ++word)
+            {
+                for (uint32_t bits = visibility[word]; bits != 0; bits &= bits - 1)
+                {
+                    func(word * 32 + static_cast<size_t>(std::countr_zero(bits)));
+                }
+            }
+        }
+
+        /**
+         * \brief Turn the view masks of up to 32 objects into one visibility word per view
+         * \param views The masks, as filled by MultiFrustumCull
+         * \param count Number of masks, at most 32
+         * \param viewCount Number of views the masks were computed for
+         * \param words Filled with viewCount words, bit i of word v set when view v sees object i
+         */
+        void SplitViews(const ViewMask* views, size_t count, size_t viewCount, uint32_t* words);
+
+        /**
+         * \brief Sort objects into one list per view in a single pass over their view masks.
+         * Each block of 32 masks is split into a word per view, so every list is filled
+         * like ForEachVisible fills one, rather than one push into a different list per bit.
+         * \param views One mask per object, as filled by MultiFrustumCull
+         * \param objects Indexed like views
+         * \param viewCount Number of views the masks were computed for
+         * \param lists Resized to viewCount lists, each filled with the objects its view sees in increasing order
+         */
+        template <typename T>
+        void GatherViews(const std::vector<ViewMask>& views, const std::vector<T>& objects, size_t viewCount, std::vector<std::vector<T>>& lists)
+        {
+            lists.resize(viewCount);
+            for (auto& list : lists) list.clear();
+
+            uint32_t words[MaxViews];
+            for (size_t first = 0; first < views.size(); first += 32)
+            {
+                SplitViews(views.data() + first, std::min<size_t>(views.size() - first, 32), viewCount, words);
+                for (size_t view = 0; view < lists.size(); ++view)
+                {
+                    for (uint32_t bits = words[view]; bits != 0; bits &= bits - 1)
+                    {
+                        lists[view].push_back(objects[first + static_cast<size_t>(std::countr_zero(bits))]);
+                    }
+                }
+            }
+        }
+    } // namespace Culling
+} // namespace Vosgi
+
+#endif // !__CULLING_H__
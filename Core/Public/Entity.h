@@ -2,17 +2,21 @@
 #define __ENTITY_H__
 
 #include <glm/glm.hpp>
-#include <list>
 #include <memory>
 #include <algorithm>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "Transform.h"
 #include "Frustum.h"
 #include "Shader.h"
 #include "Model.h"
 #include "Behaviour.h"
+#include "ComponentPool.h"
+#include "EntityPool.h"
 #include "BoundingVolume.h"
+#include "LooseOctree.h"
 #include "Observable.h"
 
 namespace Vosgi
@@ -20,41 +24,89 @@ namespace Vosgi
     class Entity
     {
     public:
-        Entity();
-        Entity(std::string name, std::string tag);
-        ~Entity();
+        /* Create a root entity in the EntityPool, nullptr if the pool is full. */
+        static Entity* Create(std::string_view name = "New Entity", std::string_view tag = "Untagged");
+
+        /* Find a live entity by name or tag in O(1), or nullptr. */
+        static Entity* FindByName(StringId name) { return EntityPool::Instance().FindByName(name); }
+        static Entity* FindByTag(StringId tag) { return EntityPool::Instance().FindByTag(tag); }
+
+        /* Every live entity with the given tag. */
+        static const std::vector<Entity*>& FindAllByTag(StringId tag) { return EntityPool::Instance().FindAllByTag(tag); }
+
+        Entity(const Entity&) = delete;
+        Entity& operator=(const Entity&) = delete;
 
-        void AddChild(std::unique_ptr<Entity> child);
+        void AddChild(Entity* child);
         void RemoveChild(Entity* child);
         void RemoveChild(size_t index);
 
+        /* Queue this entity and its children for destruction at the end of the frame. */
+        void Destroy();
+
+        /* Refresh the spatial index and culling bounds after the transform moved. */
+        void UpdateBounds();
+
+        /* World bounds of the model, or a point at the position for entities without one. */
+        AABB GetWorldBounds() const;
+
+        /* Recompute the merged bounds of the entities below that changed since the last call, see GetSubtreeBounds. */
+        void RefitSubtreeBounds();
+
+        /* Mark the merged bounds of this entity and its ancestors as out of date. */
+        void InvalidateSubtreeBounds();
+
+        /* World bounds enclosing the active models of this entity and all its descendants, false if there are none. */
+        bool GetSubtreeBounds(AABB& bounds) const;
+
         void SetEnabled(bool value);
 
         // Getters and Setters
-        std::list<std::unique_ptr<Entity>>& GetChildren() { return children; }
-        std::string GetGUID() const { return GUID; }
-        std::list<std::unique_ptr<Behaviour>>& GetBehaviours() { return behaviours; }
-
-        /* Add a behaviour to this entity. */
+        EntityHandle GetHandle() const { return handle; }
+        const std::string& GetName() const { return name; }
+        void SetName(std::string_view value) { EntityPool::Instance().SetName(*this, value); }
+        StringId GetTag() const { return tag; }
+        void SetTag(std::string_view value) { EntityPool::Instance().SetTag(*this, value); }
+        bool CompareTag(StringId value) const { return tag == value; }
+        Entity* GetParent() const;
+        Entity* GetFirstChild() const;
+        Entity* GetNextSibling() const;
+        size_t GetChildCount() const;
+        const GUID& GetGUID() const { return guid; }
+        const std::vector<Behaviour*>& GetBehaviours() const { return behaviours; }
+
+        /* Add a behaviour to this entity. It is allocated from the pool of its type. */
         template <typename T, typename... Args>
         T* AddBehaviour(Args&&... args)
         {
             static_assert(std::is_base_of<Behaviour, T>::value, "Must be derived from Behaviour");
-            T* behaviour = new T(std::forward<Args>(args)...);
+            T* behaviour = ComponentPool<T>::Instance().Create(std::forward<Args>(args)...);
+            behaviour->entity = this;
             behaviour->transform = &transform;
             behaviour->OnEnable();
-            behaviours.push_back(std::unique_ptr<T>(behaviour));
+            behaviours.push_back(behaviour);
+            IndexBehaviour(behaviour);
             return behaviour;
         }
 
-        /* Get the first behaviour of the given type. */
+        /* Get the first behaviour of exactly the given type in O(1). */
+        template <typename T>
+        T* GetExactBehaviour() const
+        {
+            const ComponentTypeId type = GetComponentTypeId<T>();
+            return type < behavioursByType.size() ? static_cast<T*>(behavioursByType[type]) : nullptr;
+        }
+
+        /* Get the first behaviour of the given type. Base types fall back to a scan. */
         template <typename T>
         T* GetBehaviour() const
         {
             static_assert(std::is_base_of<Behaviour, T>::value, "Must be derived from Behaviour");
-            for (const auto& behaviour : behaviours)
+            if (T* behaviour = GetExactBehaviour<T>()) return behaviour;
+
+            for (auto* behaviour : behaviours)
             {
-                T* castBehaviour = dynamic_cast<T*>(behaviour.get());
+                T* castBehaviour = dynamic_cast<T*>(behaviour);
 
                 if (!castBehaviour) continue;
                 return castBehaviour;
@@ -62,20 +114,18 @@ namespace Vosgi
             return nullptr;
         }
 
-        /* Get all behaviours of the given type. */
+        /* Append all behaviours of the given type to the output, without allocating a new container. */
         template <typename T>
-        std::list<T*> GetBehaviours() const
+        void GetBehaviours(std::vector<T*>& castBehaviours) const
         {
             static_assert(std::is_base_of<Behaviour, T>::value, "Must be derived from Behaviour");
-            std::list<T*> castBehaviours = std::list<T*>();
-            for (const auto& behaviour : behaviours)
+            for (auto* behaviour : behaviours)
             {
-                T* castBehaviour = dynamic_cast<T*>(behaviour.get());
+                T* castBehaviour = dynamic_cast<T*>(behaviour);
 
                 if (!castBehaviour) continue;
                 castBehaviours.push_back(castBehaviour);
             }
-            return castBehaviours;
         }
 
         /* Remove all behaviours of the given type. */
@@ -83,35 +133,75 @@ namespace Vosgi
         void RemoveBehaviour()
         {
             static_assert(std::is_base_of<Behaviour, T>::value, "Must be derived from Behaviour");
-            behaviours.remove_if([](const std::unique_ptr<Behaviour>& behaviour) {
-                return dynamic_cast<T*>(behaviour.get()) != nullptr;
+            auto it = std::remove_if(behaviours.begin(), behaviours.end(), [](Behaviour* behaviour) {
+                if (dynamic_cast<T*>(behaviour) == nullptr) return false;
+                ComponentPoolBase::Release(behaviour);
+                return true;
             });
+            behaviours.erase(it, behaviours.end());
+            RebuildBehaviourIndex();
         }
 
     public:
-        void UpdateSelfAndChildren();
-        void ForceUpdateSelfAndChildren();
-
-        void DrawSelfAndChildren(float deltaTime, const Frustum& frustum, Shader& shader, unsigned int& display, unsigned int& draw, unsigned int& total);
-
         void DrawInspector();
 
     public:
-        std::string name = "New Entity";
-        std::string tag = "Untagged";
         Transform transform = Transform();
 
         Observable<bool> enabled = true;
 
     private:
-        std::list<std::unique_ptr<Entity>> children = std::list<std::unique_ptr<Entity>>();
-        std::list<std::unique_ptr<Behaviour>> behaviours = std::list<std::unique_ptr<Behaviour>>();
-        Entity* parent = nullptr;
+        friend class EntityPool;
+        friend class Scene;
+
+        Entity();
+        ~Entity();
+
+        // Give back the behaviours and reset the state so the pool can reuse this entity
+        void Release();
+
+    private:
+        std::vector<Behaviour*> behaviours = std::vector<Behaviour*>();
+        // First behaviour of each exact type, indexed by component type id
+        std::vector<Behaviour*> behavioursByType = std::vector<Behaviour*>();
+
+        // Kept in the EntityPool's name and tag indices, see SetName and SetTag
+        std::string name = "New Entity";
+        StringId nameId;
+        StringId tag;
+        uint32_t nameSlot = 0;
+        uint32_t tagSlot = 0;
+
+        // Intrusive hierarchy links, maintained by the EntityPool
+        EntityHandle handle;
+        EntityHandle parent;
+        EntityHandle firstChild;
+        EntityHandle lastChild;
+        EntityHandle prevSibling;
+        EntityHandle nextSibling;
+
+        uint32_t liveIndex = 0;
+        bool pendingDestroy = false;
+
+        // Entry in LooseOctree::Main(), maintained by the EntityPool
+        LooseOctree::EntryId spatialEntry = LooseOctree::NullEntry;
+
+        // Merged bounds of the models in this subtree, refitted from the roots by RefitSubtreeBounds
+        glm::vec3 subtreeMin = glm::vec3(0.0f);
+        glm::vec3 subtreeMax = glm::vec3(0.0f);
+        bool hasSubtreeBounds = false;
+        bool subtreeDirty = true;
+
+        // Frustum planes that last rejected the subtree and the model, tested first by Scene::Cull
+        uint8_t subtreeRejectingPlane = 0;
+        uint8_t modelRejectingPlane = 0;
 
-        std::string GUID = RandomGUID(8);
+        GUID guid;
 
     private:
         void AssignEvents();
+        void IndexBehaviour(Behaviour* behaviour);
+        void RebuildBehaviourIndex();
     };
 } // namespace Vosgi
 
@@ -0,0 +1,170 @@
+#ifndef __ENTITY_POOL_H__
+#define __ENTITY_POOL_H__
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "StringId.h"
+
+namespace Vosgi
+{
+    class Entity;
+
+    /**
+     * \brief Generational 32-bit reference to an entity.
+     *
+     * The low bits index a slot of the EntityPool and the high bits hold the
+     * slot's generation, so a handle to a destroyed entity stops resolving
+     * even after its slot has been reused.
+     */
+    struct EntityHandle
+    {
+        static constexpr uint32_t IndexBits = 20;
+        static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+        static constexpr uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+        static constexpr uint32_t MaxIndex = IndexMask;
+
+        uint32_t value = 0; /** 0 is never a valid handle, generations start at 1 */
+
+        EntityHandle() = default;
+        EntityHandle(uint32_t index, uint32_t generation) : value((generation << IndexBits) | index) {}
+
+        uint32_t GetIndex() const { return value & IndexMask; }
+        uint32_t GetGeneration() const { return value >> IndexBits; }
+        bool IsValid() const { return value != 0; }
+
+        bool operator==(const EntityHandle& other) const { return value == other.value; }
+        bool operator!=(const EntityHandle& other) const { return value != other.value; }
+    };
+
+    /**
+     * \brief Owns every entity of the game.
+     *
+     * Entities are constructed in fixed-size chunks so their addresses stay
+     * valid, and destroyed slots are kept constructed and reset on reuse, so
+     * spawning and destroying entities does not touch the general-purpose
+     * allocator once the pool has grown. Destruction is deferred until
+     * FlushDestroyed() is called at the end of the frame.
+     */
+    class EntityPool
+    {
+    public:
+        static constexpr uint32_t ChunkSize = 256;
+
+        static EntityPool& Instance();
+
+        EntityPool(const EntityPool&) = delete;
+        EntityPool& operator=(const EntityPool&) = delete;
+        ~EntityPool();
+
+        /** \brief Create a root entity, or nullptr once MaxIndex + 1 entities are alive */
+        Entity* Create(std::string_view name, std::string_view tag);
+
+        /** \brief Resolve a handle, or nullptr if the entity was destroyed */
+        Entity* Get(EntityHandle handle) const;
+
+        /** \brief Queue the entity and its children for destruction at the end of the frame */
+        void Destroy(EntityHandle handle);
+
+        /** \brief Destroy every entity queued since the last flush */
+        void FlushDestroyed();
+
+        /** \brief Queue every root, and with it every entity, for destruction */
+        void DestroyAll();
+
+        /**
+         * \brief Move an entity under a new parent
+         * \param child The entity to move
+         * \param parent The new parent, or nullptr to make it a root
+         */
+        void SetParent(Entity& child, Entity* parent);
+
+        /** \brief The first root entity, the others follow through Entity::GetNextSibling */
+        Entity* GetFirstRoot() const { return Get(firstRoot); }
+
+        /** \brief Every live entity, densely packed in no particular order */
+        const std::vector<Entity*>& GetEntities() const { return live; }
+
+        /** \brief A live entity with the given name, or nullptr */
+        Entity* FindByName(StringId name) const;
+
+        /** \brief A live entity with the given tag, or nullptr */
+        Entity* FindByTag(StringId tag) const;
+
+        /** \brief Every live entity with the given tag, in no particular order */
+        const std::vector<Entity*>& FindAllByTag(StringId tag) const;
+
+        /** \brief Rename an entity, keeping the name index up to date */
+        void SetName(Entity& entity, std::string_view name);
+
+        /** \brief Retag an entity, keeping the tag index up to date */
+        void SetTag(Entity& entity, std::string_view tag);
+
+    private:
+        EntityPool();
+
+        // Raw storage for ChunkSize entities, defined where Entity is complete
+        struct Chunk;
+
+        Entity* Slot(uint32_t index) const;
+
+        void Link(Entity& entity, Entity* parent);
+        void Unlink(Entity& entity);
+        void DestroyImmediate(Entity& entity);
+
+        /**
+         * \brief Entities sharing a key, each storing its position in the bucket for O(1) removal.
+         *
+         * Open-addressed on the key hash with linear probing. Buckets are never
+         * removed and keep their capacity, so once a name or tag has been seen,
+         * spawning and destroying entities with it does not allocate.
+         */
+        class Index
+        {
+        public:
+            explicit Index(size_t capacity);
+
+            /** \brief The bucket of the key, or nullptr if it was never used */
+            const std::vector<Entity*>* Find(StringId key) const;
+
+            /** \brief The bucket of the key, created empty if needed */
+            std::vector<Entity*>& Get(StringId key);
+
+        private:
+            size_t Probe(StringId key) const;
+
+            // Bucket index + 1 per slot, 0 when empty, a power of two in size
+            std::vector<uint32_t> slots;
+            // Deque so FindAllByTag can hand out references that survive growth
+            std::deque<std::pair<StringId, std::vector<Entity*>>> buckets;
+        };
+
+        // Return the position of the entity in its bucket
+        static uint32_t Insert(Index& index, StringId key, Entity* entity);
+        // Return the entity moved into the freed position, if any
+        static Entity* Erase(Index& index, StringId key, uint32_t position);
+
+    private:
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        std::vector<uint32_t> generations = std::vector<uint32_t>();
+        std::vector<uint32_t> freeSlots = std::vector<uint32_t>();
+        uint32_t slotCount = 0;
+
+        std::vector<Entity*> live = std::vector<Entity*>();
+        std::vector<EntityHandle> pendingDestroy = std::vector<EntityHandle>();
+
+        Index names = Index(1024);
+        Index tags = Index(64);
+
+        EntityHandle firstRoot;
+        EntityHandle lastRoot;
+    };
+} // namespace Vosgi
+
+#endif // !__ENTITY_POOL_H__
@@ -15,10 +15,20 @@ struct Plane
 	Plane(const glm::vec3& p1, const glm::vec3& norm) : normal(glm::normalize(norm)), distance(glm::dot(normal, p1))
 	{}
 
+	// Plane a*x + b*y + c*z + d = 0 with the positive side inside, normalized
+	explicit Plane(const glm::vec4& coefficients)
+	{
+		const float length = glm::length(glm::vec3(coefficients));
+		normal = glm::vec3(coefficients) / length;
+		distance = -coefficients.w / length;
+	}
+
 	float getSignedDistanceToPlane(const glm::vec3& point) const
 	{
 		return glm::dot(normal, point) - distance;
 	}
+
+	bool operator==(const Plane& other) const = default;
 };
 
 struct Frustum
@@ -31,6 +41,26 @@ struct Frustum
 
 	Plane farFace;
 	Plane nearFace;
+
+	// Extract the planes of a view-projection matrix with OpenGL clip space (Gribb-Hartmann)
+	static Frustum FromMatrix(const glm::mat4& viewProjection)
+	{
+		const glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		const glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		const glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		const glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		Frustum frustum;
+		frustum.leftFace = Plane(row3 + row0);
+		frustum.rightFace = Plane(row3 - row0);
+		frustum.bottomFace = Plane(row3 + row1);
+		frustum.topFace = Plane(row3 - row1);
+		frustum.nearFace = Plane(row3 + row2);
+		frustum.farFace = Plane(row3 - row2);
+		return frustum;
+	}
+
+	bool operator==(const Frustum& other) const = default;
 };
 
 #endif // !__FRUSTUM_H__
\ No newline at end of file
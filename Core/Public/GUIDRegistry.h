@@ -0,0 +1,60 @@
+#ifndef __GUID_REGISTRY_H__
+#define __GUID_REGISTRY_H__
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "GUID.h"
+#include "EntityPool.h"
+
+namespace Vosgi
+{
+    class Entity;
+    class Behaviour;
+
+    /**
+     * \brief Resolves a GUID to the entity or behaviour holding it in O(1).
+     *
+     * Entities are registered by the EntityPool and behaviours by their
+     * ComponentPool, for as long as they are alive. Entities are stored by
+     * handle, so a lookup never returns a destroyed entity.
+     *
+     * Both live in one open-addressed table with linear probing, keyed on the
+     * random GUID bits and emptied by backward shifting rather than
+     * tombstones, so registering and unregistering only allocates when the
+     * table outgrows its reserved capacity.
+     */
+    class GUIDRegistry
+    {
+    public:
+        static void Register(const GUID& guid, EntityHandle entity);
+        static void Register(const GUID& guid, Behaviour* behaviour);
+        static void Unregister(const GUID& guid);
+
+        /** \brief The entity with the given GUID, or nullptr */
+        static Entity* FindEntity(const GUID& guid);
+
+        /** \brief The behaviour with the given GUID, or nullptr */
+        static Behaviour* FindBehaviour(const GUID& guid);
+
+    private:
+        // An invalid GUID marks an empty slot
+        struct Slot
+        {
+            GUID guid;
+            EntityHandle entity;
+            Behaviour* behaviour = nullptr;
+        };
+
+        // The slot holding the GUID, or the empty slot where it would go
+        static size_t Probe(const GUID& guid);
+        static void Insert(const Slot& entry);
+
+        static std::vector<Slot> slots;
+        static size_t count;
+    };
+} // namespace Vosgi
+
+#endif // !__GUID_REGISTRY_H__
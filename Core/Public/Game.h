@@ -14,6 +14,7 @@
 #include "../Public/Camera.h"
 #include "../Public/Model.h"
 #include "../Public/Material.h"
+#include "../Public/Scene.h"
 
 // Forward declarations
 class Entity;
@@ -32,6 +33,7 @@ namespace Vosgi
 
         void Run();
 
+        void Update(float deltaTime) override;
         void Draw(float deltaTime, unsigned int& displayCount, unsigned int& drawCount, unsigned int& entityCount) override;
 
         // Callbacks
@@ -39,6 +41,10 @@ namespace Vosgi
         void MouseCallback(double xPos, double yPos) override;
         void ScrollCallback(double xOffset, double yOffset) override;
 
+    private:
+        /** \brief The camera of the entity tagged "MainCamera", or nullptr */
+        Camera* GetMainCamera() const;
+
     private:
         Window *window = nullptr;
         Shader *shader = nullptr;
@@ -49,10 +55,9 @@ namespace Vosgi
         GLfloat xChange = 0, yChange = 0;
         bool mouseFirstMoved = true;
 
-        Camera* camera;
         Material shinyMaterial;
 
-        std::vector<std::unique_ptr<Entity>> entities = std::vector<std::unique_ptr<Entity>>();
+        Scene scene;
     };
 } // namespace Vosgi
 
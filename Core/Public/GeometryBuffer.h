@@ -0,0 +1,94 @@
+#ifndef __GEOMETRY_BUFFER_H__
+#define __GEOMETRY_BUFFER_H__
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "MeshData.h"
+
+namespace Vosgi
+{
+    /**
+     * \brief Vertices and indices of every mesh, sub-allocated from one large
+     * vertex buffer and one large index buffer behind a single vertex array.
+     *
+     * Draws of different meshes only differ by their ranges, so they need no
+     * vertex array switch and a whole bucket of them can be submitted with one
+     * multi-draw call. Freed ranges are reused first-fit, and a buffer that runs
+     * out of room doubles, copying its content on the GPU.
+     *
+     * The vertex array also holds the per-instance world matrix rows read by
+     * attributes Mesh::InstanceAttribute to + 2, see BindInstances.
+     */
+    class GeometryBuffer
+    {
+    public:
+        /** \brief Where a mesh lives in the shared buffers, in vertices and indices */
+        struct Range
+        {
+            uint32_t firstVertex = 0;
+            uint32_t vertexCount = 0;
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+        };
+
+        GeometryBuffer() = default;
+        GeometryBuffer(const GeometryBuffer&) = delete;
+        GeometryBuffer& operator=(const GeometryBuffer&) = delete;
+
+        /** \brief Copy a mesh into the shared buffers, indices relative to its first vertex */
+        Range Allocate(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+
+        /** \brief Return the range of a mesh for reuse */
+        void Free(const Range& range);
+
+        GLuint GetVertexArray() const { return vertexArray; }
+
+        /**
+         * \brief Enable the instance attributes of the bound vertex array, reading Affine rows from a buffer.
+         * Instance i of a draw reads the rows at offset + (baseInstance + i) * sizeof(Affine).
+         */
+        void BindInstances(GLuint buffer, size_t offset);
+
+        /** \brief Disable the instance attributes again, for draws reading the model uniform */
+        void UnbindInstances();
+
+        /** \brief True when the context has glMultiDrawElementsIndirect with a base instance (GL 4.3) */
+        static bool SupportsMultiDrawIndirect();
+
+        /** \brief The buffers every Mesh allocates from */
+        static GeometryBuffer& Main();
+
+    private:
+        // Free blocks of a buffer, sorted by offset and merged with their neighbours
+        struct FreeList
+        {
+            std::vector<std::pair<uint32_t, uint32_t>> blocks;
+            uint32_t capacity = 0;
+
+            bool Allocate(uint32_t count, uint32_t& offset);
+            void Free(uint32_t offset, uint32_t count);
+            void Grow(uint32_t newCapacity);
+        };
+
+        void CreateVertexArray();
+
+        // Reallocate a buffer with a larger capacity, keeping its content
+        static GLuint Grow(GLuint buffer, size_t size, size_t newSize);
+
+    private:
+        GLuint vertexArray = 0;
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+
+        FreeList vertices;
+        FreeList indices;
+    };
+} // namespace Vosgi
+
+#endif // !__GEOMETRY_BUFFER_H__
@@ -0,0 +1,143 @@
+#ifndef __LOOSE_OCTREE_H__
+#define __LOOSE_OCTREE_H__
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BoundingVolume.h"
+#include "EntityPool.h"
+#include "Frustum.h"
+
+namespace Vosgi
+{
+    /**
+     * \brief Spatial index of entity bounds, for proximity and ray queries.
+     *
+     * Every node's bounds are twice the size of its cell, so an entry is
+     * stored in the cell containing its center at the deepest level whose
+     * cells are at least as large as the entry. Finding that node is pure
+     * arithmetic, which makes insertion and updates O(depth), and an entry
+     * that moves within its cell costs nothing beyond storing its new box.
+     *
+     * Entries outside the root cell are kept in the root, which queries
+     * always visit.
+     */
+    class LooseOctree
+    {
+    public:
+        using EntryId = int32_t;
+        static constexpr EntryId NullEntry = -1;
+
+        /** \brief Nearest entry hit by a ray */
+        struct RayHit
+        {
+            EntityHandle handle;
+            float distance = 0.0f;
+        };
+
+        /**
+         * \param center Center of the root cell
+         * \param halfSize Half the edge length of the root cell
+         * \param maxDepth Depth of the smallest cells, points are stored there
+         */
+        LooseOctree(const glm::vec3& center, float halfSize, uint32_t maxDepth);
+        LooseOctree(const LooseOctree&) = delete;
+        LooseOctree& operator=(const LooseOctree&) = delete;
+
+        EntryId Insert(EntityHandle handle, const AABB& bounds);
+        void Remove(EntryId entry);
+
+        /** \brief Store new bounds, moving the entry to another node only if it changed cell or size class */
+        void Update(EntryId entry, const AABB& bounds);
+
+        /** \brief Append the entities whose bounds overlap the box */
+        void QueryBox(const AABB& box, std::vector<EntityHandle>& out) const;
+
+        /** \brief Append the entities whose bounds come within radius of the point */
+        void QuerySphere(const glm::vec3& center, float radius, std::vector<EntityHandle>& out) const;
+
+        /** \brief Append the entities whose bounds are at least partly inside the frustum */
+        void QueryFrustum(const Frustum& frustum, std::vector<EntityHandle>& out) const;
+
+        /**
+         * \brief Find the nearest entity whose bounds the ray enters
+         * \param origin Start of the ray
+         * \param direction Normalized direction of the ray
+         * \param maxDistance Ignore hits further than this
+         * \param hit Set to the nearest hit, if any
+         * \return True if something was hit
+         */
+        bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+
+        size_t GetCount() const { return count; }
+
+        /** \brief The index every entity is registered into */
+        static LooseOctree& Main();
+
+    private:
+        struct Node
+        {
+            glm::vec3 center = glm::vec3(0.0f);
+            float halfSize = 0.0f;
+            uint32_t depth = 0;
+
+            int32_t parent = -1;
+            int32_t children[8] = {-1, -1, -1, -1, -1, -1, -1, -1};
+            uint32_t childCount = 0;
+
+            std::vector<EntryId> entries;
+        };
+
+        struct Entry
+        {
+            EntityHandle handle;
+            glm::vec3 center = glm::vec3(0.0f);
+            glm::vec3 extents = glm::vec3(0.0f);
+
+            // Node holding the entry and position in its list, or next free entry once removed
+            int32_t node = -1;
+            uint32_t slot = 0;
+        };
+
+        // Depth and cell coordinates of the node an entry with these bounds belongs to
+        struct Cell
+        {
+            uint32_t depth = 0;
+            uint32_t x = 0, y = 0, z = 0;
+        };
+
+        Cell FindCell(const glm::vec3& center, const glm::vec3& extents) const;
+        bool IsInCell(const Node& node, const Cell& cell) const;
+
+        // The node of a cell, created along with the missing ancestors
+        int32_t GetOrCreateNode(const Cell& cell);
+
+        void Link(EntryId entry, int32_t node);
+        void Unlink(EntryId entry);
+
+        // Free empty leaf nodes from node up to the root
+        void Prune(int32_t node);
+
+        // Visit every entry of the nodes whose loose bounds pass nodeTest
+        template <typename NodeTest, typename EntryFunc>
+        void Traverse(NodeTest&& nodeTest, EntryFunc&& entryFunc) const;
+
+    private:
+        std::vector<Node> nodes;
+        std::vector<int32_t> freeNodes;
+
+        std::vector<Entry> entries;
+        EntryId freeEntry = NullEntry;
+
+        glm::vec3 rootCenter;
+        float rootHalfSize;
+        uint32_t maxDepth;
+        size_t count = 0;
+    };
+} // namespace Vosgi
+
+#endif // !__LOOSE_OCTREE_H__
@@ -15,6 +15,9 @@ public:
     Material(GLfloat sIntensity, GLfloat shine);
     
     void Use(Shader& shader);
+
+    // Unique per constructed material, to group draws by material
+    unsigned int GetId() const { return id; }
     
     ~Material();
 
@@ -22,6 +25,11 @@ public:
     GLfloat specularIntensity = 0.0f;
     GLfloat shininess = 0.0f;
 
+private:
+    unsigned int id = 0;
+
+    static unsigned int nextId;
+
 };
 
 #endif
\ No newline at end of file
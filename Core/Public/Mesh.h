@@ -9,6 +9,8 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include "Affine.h"
+#include "GeometryBuffer.h"
 #include "MeshData.h"
 #include "Texture.h"
 
@@ -26,6 +28,15 @@ public:
 
     void ActivateTextures(Shader& shader);
     void Draw(Shader& shader);
+
+    // Issue the draw call alone, with the textures and vertex array already bound
+    void DrawElements() const;
+
+    // Draw count instances, reading their world matrices from the rows bound by GeometryBuffer::BindInstances
+    void DrawElementsInstanced(int count) const;
+
+    // First of the three vertex attributes holding the rows of the instance world matrix
+    static constexpr GLuint InstanceAttribute = 3;
     void Clear();
 
     // Get vertices, indices and textures
@@ -33,8 +44,30 @@ public:
     const std::vector<unsigned int>& GetIndices() const { return meshFilter.indices; }
     const std::vector<Texture>& GetTextures() const { return meshFilter.textures; }
 
+    // Model space bounds of the vertices, computed once on Update
+    const glm::vec3& GetBoundsMin() const { return boundsMin; }
+    const glm::vec3& GetBoundsMax() const { return boundsMax; }
+
+    // Render state, for sorting draws: meshes with the same textures share a texture set id
+    GLuint GetVAO() const { return meshFilter.VAO; }
+    unsigned int GetTextureSet() const { return textureSet; }
+
+    // Unique per upload, every mesh shares the vertex array of the geometry buffer
+    unsigned int GetId() const { return id; }
+
+    // Where the vertices and indices live in GeometryBuffer::Main()
+    const Vosgi::GeometryBuffer::Range& GetRange() const { return range; }
+
     ~Mesh();
 
 protected:
     SubMesh meshFilter = SubMesh();
+
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    unsigned int textureSet = 0;
+
+    Vosgi::GeometryBuffer::Range range;
+    unsigned int id = 0;
 };
\ No newline at end of file
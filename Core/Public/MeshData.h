@@ -28,7 +28,7 @@ struct SubMesh
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
 
-    GLuint VAO, VBO, IBO;
+    GLuint VAO = 0, VBO = 0, IBO = 0;
 
     // Constructor
     SubMesh() {}
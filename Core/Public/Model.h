@@ -5,6 +5,8 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 
+#include <map>
+#include <memory>
 #include <string.h>
 #include <vector>
 
@@ -22,9 +24,17 @@ struct Vertex;
 #include "Texture.h"
 #include "Behaviour.h"
 #include "BoundingVolume.h"
+#include "AABBTree.h"
+#include "OcclusionBuffer.h"
+#include "RenderQueue.h"
 
-// Forward declaration
+// Forward declarations
+class Material;
 class Shader;
+namespace Vosgi
+{
+    class Scene;
+}
 
 class Model : public Vosgi::Behaviour
 {
@@ -36,19 +46,67 @@ public:
 
     void Clear();
 
+    void OnEnable() override;
+    void OnDisable() override;
+
+    /** \brief Refit the culling proxy after the transform moved, return the new world bounds */
+    Vosgi::AABB UpdateBounds();
+
     void Draw(const Frustum& frustum, Shader& shader, unsigned int& display, unsigned int& draw) override;
     void DrawInspector() override;
 
+    /**
+     * \brief Queue the meshes inside the frustum
+     * \param material Used unless the model has its own, nullptr to keep the current one
+     * \param eye Camera position, to sort the meshes by depth
+     */
+    void Enqueue(Vosgi::RenderQueue& queue, const Frustum& frustum, Shader& shader, Material* material, const glm::vec3& eye, unsigned int& display, unsigned int& draw);
+
+    /** \brief Material of every mesh, or nullptr to use the scene's */
+    Material* GetMaterial() const { return m_material; }
+    void SetMaterial(Material* material) { m_material = material; }
+
+    /** \brief Transparent models are blended after the opaque ones, from back to front */
+    bool IsTransparent() const { return m_isTransparent; }
+    void SetTransparent(bool value) { m_isTransparent = value; }
+
     const std::vector<Mesh*>& GetMeshes() const { return meshes; }
 
-    Vosgi::AABB* GetWorldAABB();
+    /** \brief Bounds of all meshes in model space */
+    const Vosgi::AABB& GetLocalAABB() const { return *aabb; }
+
+    /** \brief Bounds of all meshes in world space, as of the last hierarchy update */
+    Vosgi::AABB GetWorldAABB() const;
+
+    /** \brief Screen size in pixels below which the model is skipped, negative to use the scene's threshold */
+    float GetMinScreenSize() const { return m_minScreenSize; }
+    void SetMinScreenSize(float pixels) { m_minScreenSize = pixels; }
+
+    /** \brief Occluders are rasterized into the occlusion buffer, they should be large and mostly closed */
+    bool IsOccluder() const { return m_isOccluder; }
+    void SetOccluder(bool value) { m_isOccluder = value; }
+
+    /** \brief Queue every mesh into the buffer, which keeps pointing at their vertices until it rasterizes */
+    void AddOccluders(Vosgi::OcclusionBuffer& buffer) const;
 
 private:
+    // Owns the meshes, shared by every model loaded from the same file so their draws can be instanced
+    struct MeshSet;
+    std::shared_ptr<MeshSet> meshSet;
+
     std::vector<Mesh*> meshes = std::vector<Mesh*>();
     std::vector<Texture> texturesLoaded = std::vector<Texture>();
     std::string directory = std::string();   
     std::unique_ptr<Vosgi::AABB> aabb;
 
+    // Leaf in AABBTree::Main() while the model is enabled
+    Vosgi::AABBTree::ProxyId cullProxy = Vosgi::AABBTree::NullProxy;
+
+    void DestroyCullProxy();
+
+    // Mesh sets by file path, while a model still uses them
+    static std::map<std::string, std::weak_ptr<MeshSet>> loadedMeshSets;
+
     void LoadModel(const std::string& fileName);
     void ProcessNode(aiNode* node, const aiScene* scene);
     Mesh* ProcessMesh(aiMesh* mesh, const aiScene* scene);
@@ -56,8 +114,20 @@ private:
     std::vector<Texture> LoadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
     unsigned int TextureFromFile(const char* path, const std::string& directory, bool gamma = false);
 
+private:
+    friend class Vosgi::Scene;
+
+    // Temporal culling state kept by the scene, valid while the transform version matches
+    uint32_t cacheVersion = 0;
+    bool cacheWatched = false;
+    uint8_t cacheRejectingPlane = 0;
+
 private:
     bool m_isWireframe = false;
+    bool m_isOccluder = false;
+    bool m_isTransparent = false;
+    Material* m_material = nullptr;
+    float m_minScreenSize = -1.0f;
 };
 
 #endif // !__MODEL_H__
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef __OCCLUSION_BUFFER_H__
+#define __OCCLUSION_BUFFER_H__
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Affine.h"
+
+namespace Vosgi
+{
+    /**
+     * \brief Low resolution depth buffer rasterized on the CPU from a few large occluders.
+     *
+     * Every frame the queued occluders are transformed, binned into
+     * horizontal bands and rasterized by a pool of worker threads, one band
+     * at a time per worker, with SIMD spans. A pyramid keeping the farthest
+     * depth of each 2x2 block is then built over the result, so a box is
+     * tested by comparing its nearest depth to a handful of texels covering
+     * its screen rectangle, whatever its size.
+     *
+     * Occluder triangles crossing the camera plane are dropped rather than
+     * clipped, and boxes crossing it are always visible, so only hidden
+     * objects are rejected, up to the rasterization precision.
+     */
+    class OcclusionBuffer
+    {
+    public:
+        /**
+         * \param width Horizontal resolution of the depth buffer
+         * \param height Vertical resolution of the depth buffer
+         * \param threadCount Threads rasterizing, the calling thread included
+         */
+        OcclusionBuffer(uint32_t width, uint32_t height, uint32_t threadCount = GetDefaultThreadCount());
+        ~OcclusionBuffer();
+
+        OcclusionBuffer(const OcclusionBuffer&) = delete;
+        OcclusionBuffer& operator=(const OcclusionBuffer&) = delete;
+
+        /** \brief Clear the depth and forget the occluders of the previous frame */
+        void Begin(const glm::mat4& viewProjection);
+
+        /**
+         * \brief Queue a triangle mesh, referenced rather than copied until Rasterize returns
+         * \param positions Position of the first vertex
+         * \param stride Bytes from one position to the next
+         * \param indices Three per triangle, counter-clockwise when seen from the front
+         * \param indexCount Number of indices
+         * \param world Model to world transform
+         */
+        void AddOccluder(const glm::vec3* positions, size_t stride, const uint32_t* indices, size_t indexCount, const Affine& world);
+
+        /** \brief Rasterize the queued occluders and build the depth pyramid */
+        void Rasterize();
+
+        /** \brief False if the occluders hide the whole world-space box */
+        bool IsVisible(const glm::vec3& center, const glm::vec3& extents) const;
+
+        uint32_t GetWidth() const { return width; }
+        uint32_t GetHeight() const { return height; }
+
+        /** \brief Triangles written by the last Rasterize, after dropping back faces and clipped ones */
+        size_t GetRasterizedCount() const { return rasterizedCount; }
+
+        /** \brief Depth in [0, 1] of every pixel, rows of GetStride() floats from the bottom of the screen */
+        const std::vector<float>& GetDepth() const { return levels[0].depth; }
+
+        /** \brief Floats per row of the depth buffer, past the width so SIMD spans never need a scalar tail */
+        uint32_t GetStride() const { return stride; }
+
+        /** \brief One thread per core, leaving the others for the rest of the frame */
+        static uint32_t GetDefaultThreadCount();
+
+    private:
+        struct Occluder
+        {
+            const glm::vec3* positions = nullptr;
+            size_t stride = 0;
+            const uint32_t* indices = nullptr;
+            glm::mat4 toClip = glm::mat4(1.0f);
+        };
+
+        // Screen-space setup of a front-facing triangle, edge functions are positive inside
+        struct Triangle
+        {
+            float edgeA[3], edgeB[3], edgeC[3];
+            float depthX, depthY, depthC;
+            int32_t minX, minY, maxX, maxY;
+        };
+
+        struct Level
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<float> depth;
+        };
+
+        struct Workers;
+
+        // Returns false when the triangle is back-facing, offscreen or crosses the camera plane
+        bool SetupTriangle(const Occluder& occluder, size_t triangle, Triangle& out) const;
+
+        void RasterizeBand(uint32_t band);
+        void BuildPyramid();
+
+    private:
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;
+        uint32_t bandCount;
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+
+        std::vector<Occluder> occluders;
+        // Index of the first triangle of each occluder in triangles, plus the total
+        std::vector<size_t> firstTriangles = std::vector<size_t>(1, 0);
+
+        std::vector<Triangle> triangles;
+        std::vector<uint8_t> accepted;
+        std::vector<std::vector<uint32_t>> bins;
+        size_t rasterizedCount = 0;
+
+        // Level 0 is the depth buffer, including the row padding, each next level is half the size
+        std::vector<Level> levels;
+
+        std::unique_ptr<Workers> workers;
+    };
+} // namespace Vosgi
+
+#endif // !__OCCLUSION_BUFFER_H__
@@ -0,0 +1,79 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+namespace Vosgi
+{
+    /**
+     * \brief Per-frame timings and counters shown in the Profiler window.
+     *
+     * Samples are looked up by name and reset at the start of every frame, so
+     * engine systems can report their cost without knowing about the UI.
+     */
+    class Profiler
+    {
+    public:
+        using Clock = std::chrono::high_resolution_clock;
+
+        /** \brief A named sample, either a timer (milliseconds), a counter or a value */
+        struct Sample
+        {
+            const char* name = nullptr;
+            double milliseconds = 0.0;
+            unsigned int count = 0;
+            double value = 0.0;
+            bool isTimer = false;
+            bool isValue = false;
+        };
+
+        /** \brief Measures the lifetime of the scope and adds it to the named timer */
+        class Scope
+        {
+        public:
+            explicit Scope(const char* name) : name(name), start(Clock::now()) {}
+            ~Scope() { Profiler::AddTime(name, std::chrono::duration<double, std::milli>(Clock::now() - start).count()); }
+
+        private:
+            const char* name;
+            Clock::time_point start;
+        };
+
+        /** \brief Reset every sample, keeping their order for a stable display */
+        static void BeginFrame();
+
+        /**
+         * \brief Add elapsed time to a named timer
+         * \param name The timer name, expected to be a string literal
+         * \param milliseconds The elapsed time
+         */
+        static void AddTime(const char* name, double milliseconds);
+
+        /**
+         * \brief Add to a named counter
+         * \param name The counter name, expected to be a string literal
+         * \param count The amount to add
+         */
+        static void AddCount(const char* name, unsigned int count = 1);
+
+        /**
+         * \brief Set a named value, such as an average, replacing the previous one
+         * \param name The value name, expected to be a string literal
+         * \param value The value to show
+         */
+        static void SetValue(const char* name, double value);
+
+        /** \brief Get the samples recorded this frame */
+        static const std::vector<Sample>& GetSamples() { return samples; }
+
+    private:
+        static Sample& Find(const char* name);
+
+        static std::vector<Sample> samples;
+    };
+} // namespace Vosgi
+
+#endif // !__PROFILER_H__
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <cmath>
+#include <cstddef>
 #include <stdexcept>
 #include <string>
 
@@ -144,10 +146,10 @@ namespace Vosgi
          */
         static Quaternion Multiply(const Quaternion &lhs, const Quaternion &rhs)
         {
-            glm::quat lhsQuat(lhs.w, lhs.x, lhs.y, lhs.z);
-            glm::quat rhsQuat(rhs.w, rhs.x, rhs.y, rhs.z);
-            glm::quat resultQuat = lhsQuat * rhsQuat;
-            return Quaternion(resultQuat.x, resultQuat.y, resultQuat.z, resultQuat.w);
+            return Quaternion(lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+                              lhs.w * rhs.y + lhs.y * rhs.w + lhs.z * rhs.x - lhs.x * rhs.z,
+                              lhs.w * rhs.z + lhs.z * rhs.w + lhs.x * rhs.y - lhs.y * rhs.x,
+                              lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z);
         }
 
         /**
@@ -158,10 +160,11 @@ namespace Vosgi
          */
         static glm::vec3 Multiply(const Quaternion &rotation, const glm::vec3 &point)
         {
-            glm::quat rotationQuat(rotation.w, rotation.x, rotation.y, rotation.z);
-            glm::vec3 pointVec(point.x, point.y, point.z);
-            glm::vec3 resultVec = rotationQuat * pointVec;
-            return glm::vec3(resultVec.x, resultVec.y, resultVec.z);
+            // v + 2w(q x v) + 2q x (q x v), for a unit quaternion
+            const glm::vec3 axis(rotation.x, rotation.y, rotation.z);
+            const glm::vec3 uv = glm::cross(axis, point);
+            const glm::vec3 uuv = glm::cross(axis, uv);
+            return point + (uv * rotation.w + uuv) * 2.0f;
         }
 
         /**
@@ -172,9 +175,7 @@ namespace Vosgi
          */
         static float Dot(const Quaternion &a, const Quaternion &b)
         {
-            glm::quat aQuat(a.w, a.x, a.y, a.z);
-            glm::quat bQuat(b.w, b.x, b.y, b.z);
-            return glm::dot(aQuat, bQuat);
+            return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
         }
 
     
@@ -284,9 +285,11 @@ namespace Vosgi
          */
         Quaternion normalized() const
         {
-            glm::quat rotationQuat(w, x, y, z);
-            rotationQuat = glm::normalize(rotationQuat);
-            return Quaternion(rotationQuat.x, rotationQuat.y, rotationQuat.z, rotationQuat.w);
+            const float length = std::sqrt(Dot(*this, *this));
+            if (length <= 0.0f) return Quaternion();
+
+            const float inverseLength = 1.0f / length;
+            return Quaternion(x * inverseLength, y * inverseLength, z * inverseLength, w * inverseLength);
         }
 
         /**
@@ -315,6 +318,55 @@ namespace Vosgi
             return std::string("(" + std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(z) + ", " + std::to_string(w) + ")\n");
         }
     };
+
+    /** \brief Quaternions stored one component per array, for the batch operations */
+    struct QuaternionStream
+    {
+        float* x;
+        float* y;
+        float* z;
+        float* w;
+    };
+
+    /** \brief Vectors stored one component per array, for the batch operations */
+    struct Vec3Stream
+    {
+        float* x;
+        float* y;
+        float* z;
+    };
+
+    struct Affine;
+
+    /**
+     * Batch versions of the Quaternion operations, working on count elements
+     * of structure-of-arrays streams with SSE2 or AVX2 (see SIMD.h). Outputs
+     * may alias inputs of the same element.
+     */
+    namespace QuaternionBatch
+    {
+        /** \brief out[i] = lhs[i] * rhs[i] */
+        void Multiply(const QuaternionStream &lhs, const QuaternionStream &rhs, const QuaternionStream &out, size_t count);
+
+        /** \brief out[i] = rotation[i] * points[i], the rotations must be normalized */
+        void Rotate(const QuaternionStream &rotation, const Vec3Stream &points, const Vec3Stream &out, size_t count);
+
+        /** \brief out[i] = normalized(rotation[i]), zero quaternions become the identity */
+        void Normalize(const QuaternionStream &rotation, const QuaternionStream &out, size_t count);
+
+        /** \brief Normalized linear interpolation along the shortest path */
+        void Nlerp(const QuaternionStream &from, const QuaternionStream &to, const float *t, const QuaternionStream &out, size_t count);
+
+        /**
+         * \brief Spherical interpolation along the shortest path, with t in [0, 1].
+         * Uses Eberly's polynomial approximation, within 3e-5 of the exact
+         * weights and without any trigonometric call, so it vectorizes.
+         */
+        void Slerp(const QuaternionStream &from, const QuaternionStream &to, const float *t, const QuaternionStream &out, size_t count);
+
+        /** \brief Rotation matrices without translation, the rotations must be normalized */
+        void ToMatrix(const QuaternionStream &rotation, Affine *out, size_t count);
+    } // namespace QuaternionBatch
 }
 
 #endif // __QUATERNION_H__
@@ -0,0 +1,161 @@
+#ifndef __RENDER_QUEUE_H__
+#define __RENDER_QUEUE_H__
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Affine.h"
+#include "StreamBuffer.h"
+
+// Forward declarations
+class Material;
+class Mesh;
+class Shader;
+
+namespace Vosgi
+{
+    /**
+     * \brief Draw calls gathered over a frame, sorted to minimize GL state changes before submission.
+     *
+     * Culling emits one compact item per mesh, with a 64-bit key packing the
+     * pass, the state the mesh needs and its depth:
+     *
+     *     opaque:      0 | wireframe | program:6 | material:10 | textures:12 | mesh:12 | depth:22
+     *     transparent: 1 | far-to-near depth:22 | wireframe | program:6 | material:10 | textures:12 | mesh:12
+     *
+     * Opaque items are grouped by state then drawn front to back within a group,
+     * transparent ones are drawn back to front after them. The keys are radix
+     * sorted and submission only binds the state that differs from the previous
+     * item, comparing the actual state, so ids that alias in a key field only
+     * cost ordering.
+     *
+     * Consecutive opaque items drawing the same mesh with the same state are
+     * merged into one instanced draw, their world matrices written straight
+     * into the per-frame StreamBuffer::Main().
+     *
+     * Every mesh lives in the buffers of GeometryBuffer::Main(), so with
+     * GL 4.3 the instanced draws of a whole bucket sharing program, material,
+     * textures and fill mode go out as one glMultiDrawElementsIndirect call,
+     * each command selecting its world matrices by base instance. Older
+     * contexts fall back to one draw call per batch.
+     */
+    class RenderQueue
+    {
+    public:
+        /** \brief One mesh to draw */
+        struct Item
+        {
+            uint64_t key = 0;
+            Mesh* mesh = nullptr;
+            const Affine* model = nullptr;
+            Shader* shader = nullptr;
+            // Left as is when null
+            Material* material = nullptr;
+            bool transparent = false;
+            bool wireframe = false;
+        };
+
+        /** \brief State changes issued by the last Submit */
+        struct Stats
+        {
+            uint32_t programs = 0;
+            uint32_t materials = 0;
+            uint32_t textures = 0;
+            uint32_t vertexArrays = 0;
+            // Draw calls issued, and the items drawn by the instanced ones
+            uint32_t draws = 0;
+            uint32_t instances = 0;
+            // Commands submitted by the multi-draw calls
+            uint32_t commands = 0;
+
+            uint32_t GetStateChanges() const { return programs + materials + textures + vertexArrays; }
+        };
+
+        /** \brief Fewest items of the same mesh drawn as instances rather than one by one */
+        static constexpr size_t MinInstances = 2;
+
+        /** \brief Forget the items of the previous frame, keeping the memory */
+        void Clear();
+
+        /**
+         * \brief Queue a mesh
+         * \param model World matrix, referenced until Submit returns
+         * \param material Uniforms to set before the draw, or nullptr to keep the current ones
+         * \param depth Distance from the camera
+         */
+        void Add(Mesh& mesh, const Affine& model, Shader& shader, Material* material, float depth, bool transparent, bool wireframe);
+
+        /** \brief Order the queued items by key */
+        void Sort();
+
+        /** \brief Issue the draws in sorted order, binding only the state that changed and instancing repeated meshes */
+        Stats Submit();
+
+        /** \brief Submit buckets with multi-draw indirect calls when the context supports them, on by default */
+        void SetMultiDrawIndirect(bool enabled) { multiDrawIndirect = enabled; }
+        bool IsMultiDrawIndirect() const { return multiDrawIndirect; }
+
+        size_t Size() const { return items.size(); }
+
+        /** \brief The queued items, in the order they were added */
+        const std::vector<Item>& GetItems() const { return items; }
+
+        /** \brief Indices into GetItems(), in submission order after Sort */
+        const std::vector<uint32_t>& GetOrder() const { return order; }
+
+        /** \brief Pack the sort key of a draw, see the class description */
+        static uint64_t MakeKey(uint32_t program, uint32_t material, uint32_t textures, uint32_t mesh, float depth, bool transparent, bool wireframe);
+
+    private:
+        struct SortEntry
+        {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        // Items order[begin, begin + count) drawn with the state of the first one
+        struct Batch
+        {
+            uint32_t begin;
+            uint32_t count;
+            // Index of the first world matrix in instances, for opaque batches
+            uint32_t firstInstance;
+        };
+
+        // Layout read by glMultiDrawElementsIndirect
+        struct DrawCommand
+        {
+            uint32_t count;
+            uint32_t instanceCount;
+            uint32_t firstIndex;
+            int32_t baseVertex;
+            uint32_t baseInstance;
+        };
+
+        // Group the sorted items into batches and write the world matrices of the opaque ones,
+        // with one indirect command per opaque batch when submitting them that way
+        void BuildBatches(bool indirect);
+
+        std::vector<Item> items;
+        std::vector<uint32_t> order;
+
+        // Radix sort buffers, kept across frames
+        std::vector<SortEntry> entries;
+        std::vector<SortEntry> scratch;
+
+        std::vector<Batch> batches;
+
+        // Allocated from the stream buffer for this frame, opaque batches come first and command i draws batch i
+        StreamBuffer::Allocation instances;
+        StreamBuffer::Allocation commands;
+        size_t commandCount = 0;
+
+        bool multiDrawIndirect = true;
+    };
+} // namespace Vosgi
+
+#endif // !__RENDER_QUEUE_H__
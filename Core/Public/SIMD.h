@@ -0,0 +1,53 @@
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+#pragma once
+
+/*
+ * Instruction set selection for the batch kernels.
+ *
+ * Kernels are compiled for every level the target architecture allows and
+ * picked at runtime from what the CPU supports, so the executable does not
+ * require AVX2 to start.
+ */
+
+// SSE2 is part of x86-64, so only the AVX2 kernels need a runtime check
+#if defined(__x86_64__) || defined(_M_X64)
+#define VOSGI_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define VOSGI_SIMD_X86 0
+#endif
+
+// GCC and Clang only emit AVX2 instructions inside functions marked for it, MSVC always can
+#if VOSGI_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define VOSGI_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define VOSGI_TARGET_AVX2
+#endif
+
+namespace Vosgi
+{
+    namespace SIMD
+    {
+        enum class Level
+        {
+            Scalar,
+            SSE2,
+            AVX2,
+        };
+
+        /** \brief The best level supported by this CPU and OS */
+        Level GetSupportedLevel();
+
+        /** \brief The level the kernels currently dispatch to */
+        Level GetLevel();
+
+        /** \brief Force a lower level, to compare kernels. Clamped to the supported level. */
+        void SetLevel(Level level);
+
+        const char* GetLevelName(Level level);
+    } // namespace SIMD
+} // namespace Vosgi
+
+#endif // !__SIMD_H__
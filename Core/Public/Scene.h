@@ -0,0 +1,203 @@
+#ifndef __SCENE_H__
+#define __SCENE_H__
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "AABBTree.h"
+#include "Culling.h"
+#include "Entity.h"
+#include "Frustum.h"
+#include "ComponentPool.h"
+#include "OcclusionBuffer.h"
+#include "RenderQueue.h"
+
+// Forward declarations
+class Camera;
+class Material;
+class Shader;
+class Model;
+
+namespace Vosgi
+{
+    /**
+     * \brief Runs the frame phases over the entities of the EntityPool.
+     *
+     * Each phase is a single linear pass over the component pools:
+     * Update -> transform propagation -> LateUpdate -> propagation of what
+     * LateUpdate moved -> bounds of what moved -> frustum culling ->
+     * occlusion culling -> sorted draw submission.
+     */
+    class Scene
+    {
+    public:
+        /** \brief Which structure Cull walks to find the visible models */
+        enum class CullMode
+        {
+            // AABBTree::Main(), grouped by position
+            Tree,
+            // The entity hierarchy, rejecting whole branches through their subtree bounds
+            Hierarchy,
+            // Results kept per model, only the models near the frustum or that moved are tested again
+            Temporal
+        };
+
+        Scene() = default;
+        ~Scene() = default;
+
+        /** \brief The first root entity, the others follow through Entity::GetNextSibling */
+        Entity* GetFirstRoot() const { return EntityPool::Instance().GetFirstRoot(); }
+
+        /** \brief Run Update and LateUpdate on every active behaviour, propagating transforms after each */
+        void Update(float deltaTime);
+
+        /**
+         * \brief Find the models the camera sees through the structure selected by the cull mode,
+         * then drop the ones too small on screen and, if enabled, the ones hidden behind occluders.
+         * In Tree mode the frustum result is kept when neither the frustum nor the tree changed.
+         * \param camera The camera providing the frustum and projection
+         * \param viewportHeight Height of the render target in pixels, for the screen size threshold
+         */
+        void Cull(const Camera& camera, float viewportHeight);
+
+        /**
+         * \brief Cull the active models against several views in one pass over their bounds,
+         * for cameras other than the main one. Skips the screen size and occlusion tests.
+         * \param frustums One per view, at most Culling::MaxViews
+         * \param drawLists Resized to one list per view, filled with the models the view sees
+         */
+        void CullViews(const std::vector<Frustum>& frustums, std::vector<std::vector<Model*>>& drawLists);
+
+        CullMode GetCullMode() const { return cullMode; }
+        void SetCullMode(CullMode mode) { cullMode = mode; cullValid = false; }
+
+        /** \brief Models whose bounds cover fewer pixels on screen are skipped, unless they override it */
+        float GetMinScreenSize() const { return minScreenSize; }
+        void SetMinScreenSize(float pixels) { minScreenSize = pixels; }
+
+        /** \brief Test the frustum culled models against a depth buffer of the occluders, rasterized on the CPU */
+        bool GetOcclusionCulling() const { return occlusion != nullptr; }
+        void SetOcclusionCulling(bool value);
+
+        /**
+         * \brief Queue the meshes of the models kept by Cull, sort them by state and depth and submit them
+         * \param material Used by the models without their own
+         */
+        void Draw(const Frustum& frustum, Shader& shader, Material& material, unsigned int& display, unsigned int& draw);
+
+        /** \brief Queue the models are drawn through, for its submission settings */
+        RenderQueue& GetRenderQueue() { return renderQueue; }
+
+        /** \brief Destroy the entities queued during the frame */
+        void EndFrame();
+
+        /** \brief Number of enabled entities gathered this frame */
+        unsigned int GetEntityCount() const { return entityCount; }
+
+        /**
+         * \brief Call func(entity, t, others...) for every entity holding all the given behaviour types.
+         *
+         * Iterates the pool of the first type linearly and resolves the others
+         * through the entity's O(1) type index, so list the rarest type first.
+         */
+        template <typename T, typename... Others, typename Func>
+        static void Each(Func&& func)
+        {
+            ComponentPool<T>::Instance().ForEach([&func](T& behaviour) {
+                Entity* entity = behaviour.entity;
+                if (!entity) return;
+                if (!((entity->template GetExactBehaviour<Others>() != nullptr) && ...)) return;
+
+                func(*entity, behaviour, *entity->template GetExactBehaviour<Others>()...);
+            });
+        }
+
+    private:
+        static void PropagateTransforms();
+
+        /** \brief Refit the spatial index and culling tree entries of the entities that moved */
+        void SyncBounds();
+
+        void CullTree(const Frustum& frustum);
+        void CullHierarchy(const Frustum& frustum);
+        void CullTemporal(const Frustum& frustum, const glm::vec3& eye);
+
+        /**
+         * \brief Test every active model against the frustum, keeping the ones that will stay
+         * outside while the camera moves within the thresholds out of the watched list
+         */
+        void RefreshTemporal(const Frustum& frustum, const glm::vec3& eye);
+
+        /** \brief Test a model against the reference frustum, watching it unless it is safely outside */
+        void ClassifyTemporal(Model& model);
+
+        /**
+         * \brief Fill drawModels with the visible models large enough on screen
+         * \param eye Camera position
+         * \param pixelsPerUnit Pixels covered by one world unit at distance one
+         */
+        void CullSmall(const glm::vec3& eye, float pixelsPerUnit);
+
+        /** \brief Remove the models hidden behind an occluder from drawModels */
+        void Occlude(const glm::mat4& viewProjection);
+
+        /** \brief Collect the active models of the subtree, skipping the branches outside the frustum */
+        void CullSubtree(Entity& entity, const Frustum& frustum, uint8_t planes, Culling::PlaneStats& stats);
+
+        /** \brief Collect the active models of the subtree without testing them */
+        void CollectSubtree(Entity& entity);
+
+        /** \brief Call Draw on every active behaviour of the pool */
+        template <typename T>
+        static void DrawPool(const Frustum& frustum, Shader& shader, unsigned int& display, unsigned int& draw)
+        {
+            ComponentPool<T>::Instance().ForEach([&](T& behaviour) {
+                if (!behaviour.IsActive()) return;
+                behaviour.Draw(frustum, shader, display, draw);
+            });
+        }
+
+    private:
+        // Models inside the frustum, reused to avoid reallocating every frame
+        std::vector<Model*> visibleModels = std::vector<Model*>();
+        // Visible models that are large enough and not occluded, in submission order
+        std::vector<Model*> drawModels = std::vector<Model*>();
+
+        // Bounds of the active models and the views that see each of them, for CullViews
+        BoundsArrays viewBounds = BoundsArrays();
+        std::vector<Model*> viewModels = std::vector<Model*>();
+        std::vector<ViewMask> viewMasks = std::vector<ViewMask>();
+        VisibilityMask viewVisibility = VisibilityMask();
+
+        // Temporal mode: models tested every frame, and the models that moved since the last Cull
+        std::vector<Model*> watchedModels = std::vector<Model*>();
+        std::vector<Model*> movedModels = std::vector<Model*>();
+
+        // Meshes of drawModels, rebuilt every frame
+        RenderQueue renderQueue = RenderQueue();
+        glm::vec3 viewPosition = glm::vec3(0.0f);
+
+        // Created while occlusion culling is enabled, along with its threads
+        std::unique_ptr<OcclusionBuffer> occlusion;
+
+        // What visibleModels was computed from
+        Frustum cullFrustum = Frustum();
+        uint32_t cullVersion = 0;
+        // Camera position and tree membership of the temporal reference frustum, and the frustum tested last
+        glm::vec3 cullEye = glm::vec3(0.0f);
+        Frustum temporalFrustum = Frustum();
+        uint32_t cullMembership = 0;
+        // Reported again by the frames that reuse the visible models
+        float cullPlanesPerTest = 0.0f;
+        bool cullValid = false;
+        CullMode cullMode = CullMode::Tree;
+        float minScreenSize = 2.0f;
+        unsigned int entityCount = 0;
+    };
+} // namespace Vosgi
+
+#endif // !__SCENE_H__
@@ -12,6 +12,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "Affine.h"
+
 class Shader
 {
 public:
@@ -31,8 +33,11 @@ public:
     void SetVec4(const char* name, glm::vec4 value);
     void SetVec4(const char* name, float x, float y, float z, float w);
     void SetMat4(const char* name, glm::mat4 value);
+    // Upload to a mat4x3 uniform
+    void SetAffine(const char* name, const Vosgi::Affine& value);
 
     inline void Use() { glUseProgram(shaderID); }
+    inline GLuint GetID() const { return shaderID; }
     void Clear();
 
     ~Shader();
@@ -44,6 +49,9 @@ public:
 private:
     GLuint shaderID = 0;
 
+    // Locations differ between programs, so every shader caches its own
+    std::map<std::string, GLuint> uniformLocations;
+
     void CompileShader(const char* vertexCode, const char* fragmentCode);
     void AddShader(GLuint theProgram, const char* shaderCode, GLenum shaderType);
 
@@ -51,7 +59,8 @@ private:
     std::string GetAbsolutePath(const char* fileLocation);
 
 public:
-    // Globally set uniforms
+    // Set a uniform on every program, binding each in turn. Data shared by all programs
+    // for every view belongs in a uniform block instead, see UniformBlocks.h
     static void SetGlobalBool(const char* name, bool value);
     static void SetGlobalInt(const char* name, int value);
     static void SetGlobalFloat(const char* name, float value);
@@ -65,13 +74,10 @@ private:
     // static list of all shaders
     static std::vector<Shader*> shaders;
 
-    // Map of all uniform locations
-    static std::map<std::string, GLuint> uniformLocations;
-
 public:
     // Get the sahders in a list
     static std::vector<Shader*> GetShaders() { return shaders; }
 
     // Check if a uniform location is already cached
-    static inline bool IsCached(const char* name) { return uniformLocations.find(name) != uniformLocations.end(); }
+    inline bool IsCached(const char* name) const { return uniformLocations.find(name) != uniformLocations.end(); }
 };
\ No newline at end of file
@@ -0,0 +1,106 @@
+#ifndef __STREAM_BUFFER_H__
+#define __STREAM_BUFFER_H__
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace Vosgi
+{
+    /**
+     * \brief Ring buffer for data rewritten every frame, written in place by the CPU and read by the GPU.
+     *
+     * The buffer is split in RegionCount regions, one per frame in flight.
+     * A frame sub-allocates linearly from its region, and a fence placed at
+     * EndFrame keeps the CPU from writing that region again before the GPU
+     * is done with it, three frames later. With GL 4.4 or ARB_buffer_storage
+     * the storage is immutable and stays mapped, persistent and coherent, so
+     * allocations are plain pointers into GPU-visible memory.
+     *
+     * On GL 3.3 a single region is orphaned at BeginFrame and mapped lazily,
+     * unsynchronized past the data already written. Such a mapping must be
+     * closed by Flush before a draw reads the buffer, and reopens on the next
+     * Allocate.
+     *
+     * A frame that outgrows its region moves to a larger buffer right away.
+     * The previous one, which earlier allocations of the frame may still be
+     * bound from, is deleted once every region has been through a fence.
+     */
+    class StreamBuffer
+    {
+    public:
+        /** \brief Memory written by the CPU at data, read by the GPU at offset in buffer */
+        struct Allocation
+        {
+            void* data = nullptr;
+            GLuint buffer = 0;
+            size_t offset = 0;
+            size_t size = 0;
+        };
+
+        /** \brief Frames the CPU may run ahead of the GPU */
+        static constexpr uint32_t RegionCount = 3;
+
+        /** \param regionSize Bytes each frame can allocate before the buffer grows */
+        explicit StreamBuffer(size_t regionSize);
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        /** \brief Move to the next region, waiting for the GPU to release it */
+        void BeginFrame();
+
+        /** \brief Fence the region of the frame */
+        void EndFrame();
+
+        /**
+         * \brief Reserve memory for this frame, valid until the same region comes around again
+         * \param alignment Power of two the GPU offset is a multiple of
+         */
+        Allocation Allocate(size_t size, size_t alignment = 16);
+
+        /** \brief Make the writes visible to the next draws, only needed without persistent mapping */
+        void Flush();
+
+        /** \brief True when the buffer stays mapped, false on the orphaning fallback */
+        bool IsPersistent() const { return persistent; }
+
+        /** \brief Bytes allocated since BeginFrame */
+        size_t GetUsed() const { return head; }
+
+        /** \brief Offsets of uniform blocks bound from a buffer must be multiples of this */
+        static size_t GetUniformAlignment();
+
+        /** \brief The buffer every per-frame stream allocates from, fenced by the window loop */
+        static StreamBuffer& Main();
+
+    private:
+        void Create(size_t newRegionSize);
+        void Map(size_t offset);
+
+    private:
+        GLuint buffer = 0;
+        size_t regionSize;
+        bool persistent = false;
+
+        uint32_t region = 0;
+        // Offset from the start of the region
+        size_t head = 0;
+
+        // Start of the current mapping, null while unmapped on the fallback path
+        uint8_t* mapped = nullptr;
+        size_t mappedOffset = 0;
+
+        GLsync fences[RegionCount] = {};
+
+        // Buffers replaced by a larger one, with the frames left before they can be deleted
+        std::vector<std::pair<GLuint, uint32_t>> retired;
+    };
+} // namespace Vosgi
+
+#endif // !__STREAM_BUFFER_H__
@@ -0,0 +1,66 @@
+#ifndef __STRING_ID_H__
+#define __STRING_ID_H__
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace Vosgi
+{
+    /**
+     * \brief 64-bit FNV-1a hash of a string, compared as an integer.
+     *
+     * Literals are hashed at compile time ("Light"_sid). Strings passed to
+     * Intern() are also recorded, so GetString() can give the text back for
+     * display.
+     */
+    struct StringId
+    {
+        uint64_t hash = 0;
+
+        constexpr StringId() = default;
+        constexpr explicit StringId(uint64_t hash) : hash(hash) {}
+        constexpr StringId(std::string_view text) : hash(Hash(text)) {}
+        constexpr StringId(const char* text) : hash(Hash(std::string_view(text))) {}
+        StringId(const std::string& text) : hash(Hash(text)) {}
+
+        /** \brief Hash the text and remember it for GetString */
+        static StringId Intern(std::string_view text);
+
+        /** \brief The interned text, or an empty string if it was never interned */
+        const char* GetString() const;
+
+        constexpr bool IsValid() const { return hash != 0; }
+
+        constexpr bool operator==(const StringId& other) const { return hash == other.hash; }
+        constexpr bool operator!=(const StringId& other) const { return hash != other.hash; }
+
+        static constexpr uint64_t Hash(std::string_view text)
+        {
+            uint64_t value = 0xCBF29CE484222325ull;
+            for (char c : text)
+            {
+                value ^= static_cast<unsigned char>(c);
+                value *= 0x100000001B3ull;
+            }
+            return value;
+        }
+    };
+
+    constexpr StringId operator""_sid(const char* text, size_t length)
+    {
+        return StringId(std::string_view(text, length));
+    }
+} // namespace Vosgi
+
+template <>
+struct std::hash<Vosgi::StringId>
+{
+    size_t operator()(const Vosgi::StringId& id) const noexcept { return static_cast<size_t>(id.hash); }
+};
+
+#endif // !__STRING_ID_H__
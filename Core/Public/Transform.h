@@ -9,102 +9,120 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "Quaternion.h"
+#include "TransformHierarchy.h"
 
 namespace Vosgi
 {
+    class Entity;
+
     class Transform
     {
     public:
         // Constructors
-        Transform() = default;
+        Transform();
         Transform(glm::vec3 pos, glm::quat rot, glm::vec3 scale);
+        Transform(const Transform &other);
+        Transform &operator=(const Transform &other);
         ~Transform();
 
         // Getters
-        const glm::mat4 &GetModel() const { return m_model; }
+        const Affine &GetModel() const { return TransformHierarchy::Main().GetWorld(m_node); }
+        TransformHierarchy::NodeIndex GetNode() const { return m_node; }
 
-        // Directions
-        glm::vec3 GetForward() const { return rotation * glm::vec3(0.0f, 0.0f, 1.0f); }
-        glm::vec3 GetRight() const { return rotation * glm::vec3(1.0f, 0.0f, 0.0f); }
-        glm::vec3 GetUp() const { return rotation * glm::vec3(0.0f, 1.0f, 0.0f); }
+        /** \brief Changes whenever the world matrix does, to key results derived from it */
+        uint32_t GetVersion() const { return TransformHierarchy::Main().GetVersion(m_node); }
 
-        // Getters
-        glm::vec3 GetWorldScale() const { return glm::vec3(glm::length(GetRight()), glm::length(GetUp()), glm::length(GetForward())); }
+        /** \brief The entity this transform belongs to, or nullptr for a standalone transform */
+        Entity *GetEntity() const { return m_entity; }
+
+        // World space, cached by the hierarchy until the world matrix changes
+        const glm::vec3 &GetWorldPosition() const { return GetDecomposition().position; }
+        const Quaternion &GetWorldRotation() const { return GetDecomposition().rotation; }
+        const glm::vec3 &GetWorldScale() const { return GetDecomposition().scale; }
+
+        // World space directions, normalized
+        const glm::vec3 &GetForward() const { return GetDecomposition().forward; }
+        const glm::vec3 &GetRight() const { return GetDecomposition().right; }
+        const glm::vec3 &GetUp() const { return GetDecomposition().up; }
+
+        // Directions of the local rotation, up to date before the hierarchy update
+        glm::vec3 GetLocalForward() const { return rotation * glm::vec3(0.0f, 0.0f, 1.0f); }
+        glm::vec3 GetLocalRight() const { return rotation * glm::vec3(1.0f, 0.0f, 0.0f); }
+        glm::vec3 GetLocalUp() const { return rotation * glm::vec3(0.0f, 1.0f, 0.0f); }
 
         // Setters
         void SetPosition(glm::vec3 pos)
         {
             position = pos;
-            m_isDirty = true;
+            SetDirty();
         }
 
         void SetLocalPosition(glm::vec3 pos)
         {
             localPosition = pos;
-            m_isDirty = true;
+            SetDirty();
         }
 
         void SetRotation(glm::quat rotation)
         {
             this->rotation = rotation;
-            m_isDirty = true;
+            SetDirty();
         }
 
         void SetLocalRotation(glm::quat rotation)
         {
             localRotation = rotation;
-            m_isDirty = true;
+            SetDirty();
         }
 
         void SetLocalScale(glm::vec3 scale)
         {
             localScale = scale;
-            m_isDirty = true;
+            SetDirty();
         }
 
         void SetForward(glm::vec3 forward)
         {
             glm::vec3 newForward = glm::normalize(forward);
-            glm::vec3 currentForward = GetForward();
+            glm::vec3 currentForward = GetLocalForward();
 
             float angle = glm::acos(glm::dot(currentForward, newForward));
             glm::vec3 axis = glm::cross(currentForward, newForward);
 
             rotation = glm::angleAxis(angle, axis);
-            m_isDirty = true;
+            SetDirty();
         }
 
         void SetUp(glm::vec3 up)
         {
             glm::vec3 newUp = glm::normalize(up);
-            glm::vec3 currentUp = GetUp();
+            glm::vec3 currentUp = GetLocalUp();
 
             float angle = glm::acos(glm::dot(currentUp, newUp));
             glm::vec3 axis = glm::cross(currentUp, newUp);
 
             rotation = glm::angleAxis(angle, axis);
-            m_isDirty = true;
+            SetDirty();
         }
 
         void SetRight(glm::vec3 right)
         {
             glm::vec3 newRight = glm::normalize(right);
-            glm::vec3 currentRight = GetRight();
+            glm::vec3 currentRight = GetLocalRight();
 
             float angle = glm::acos(glm::dot(currentRight, newRight));
             glm::vec3 axis = glm::cross(currentRight, newRight);
 
             rotation = glm::angleAxis(angle, axis);
-            m_isDirty = true;
+            SetDirty();
         }
 
-        // Dirty flag
-        bool IsDirty() const { return m_isDirty; }
-        void SetDirty() { m_isDirty = true; }
+        // Hierarchy
+        void SetParent(Transform *parent);
 
-        // Model matrix computation
-        void ComputeModelMatrix();
-        void ComputeModelMatrix(glm::mat4 parentModel);
+        // Dirty flag
+        bool IsDirty() const { return TransformHierarchy::Main().IsDirty(m_node); }
+        void SetDirty() { TransformHierarchy::Main().SetDirty(m_node); }
 
     public:
         // Member variables
@@ -116,14 +134,16 @@ namespace Vosgi
 
         glm::vec3 localScale = {1.0f, 1.0f, 1.0f};
 
-    protected:
-        glm::mat4 m_model = glm::mat4(1.0f);
+    private:
+        friend class TransformHierarchy;
+        friend class Entity;
 
-        bool m_isDirty = true;\
+        const TransformHierarchy::Decomposition &GetDecomposition() const { return TransformHierarchy::Main().GetDecomposition(m_node); }
 
-    private:
-        // Helper function
-        glm::mat4 GetLocalModelMatrix() const;
+        // Node holding the world matrix, kept up to date by the hierarchy when it reorders
+        TransformHierarchy::NodeIndex m_node = TransformHierarchy::InvalidNode;
+
+        Entity *m_entity = nullptr;
     };
 }
 
@@ -0,0 +1,50 @@
+#ifndef __TRANSFORM_BATCH_H__
+#define __TRANSFORM_BATCH_H__
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Affine.h"
+
+namespace Vosgi
+{
+    /**
+     * \brief Local translation, rotation and scale of many transforms, one array per component.
+     *
+     * Keeping each component contiguous lets the batch kernels load the same
+     * component of several transforms into one SIMD register.
+     */
+    struct TRSArrays
+    {
+        std::vector<float> positionX, positionY, positionZ;
+        std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+        std::vector<float> scaleX, scaleY, scaleZ;
+
+        size_t Size() const { return positionX.size(); }
+
+        /** \brief Call func on every component array, to resize or reorder them together */
+        template <typename Func>
+        void ForEachArray(Func&& func)
+        {
+            func(positionX), func(positionY), func(positionZ);
+            func(rotationX), func(rotationY), func(rotationZ), func(rotationW);
+            func(scaleX), func(scaleY), func(scaleZ);
+        }
+    };
+
+    namespace TransformBatch
+    {
+        /**
+         * \brief Compose translate * rotate * scale for a range of transforms
+         * \param trs The local components, rotations are expected to be normalized
+         * \param begin First transform of the range
+         * \param end One past the last transform of the range
+         * \param out Matrices indexed like the arrays, only [begin, end) is written
+         */
+        void ComposeTRS(const TRSArrays& trs, size_t begin, size_t end, Affine* out);
+    } // namespace TransformBatch
+} // namespace Vosgi
+
+#endif // !__TRANSFORM_BATCH_H__
@@ -0,0 +1,173 @@
+#ifndef __TRANSFORM_HIERARCHY_H__
+#define __TRANSFORM_HIERARCHY_H__
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Quaternion.h"
+#include "TransformBatch.h"
+
+namespace Vosgi
+{
+    class Transform;
+
+    /**
+     * \brief Flat store holding the hierarchy data of every Transform.
+     *
+     * Parent indices, local TRS and world matrices live in contiguous arrays.
+     * Nodes are kept ordered so that a parent always precedes its children,
+     * which lets Update() propagate world matrices in one linear sweep that
+     * only recomputes dirty nodes and the nodes below them. Local matrices of
+     * dirty nodes are composed beforehand by the SIMD batch kernel.
+     *
+     * Removed nodes leave holes that new nodes reuse, and a node re-parented
+     * under a parent stored behind it is moved to the end with its subtree,
+     * so spawning, destroying and re-parenting never resort the arrays. A
+     * full sort only runs to compact the holes once they dominate.
+     */
+    class TransformHierarchy
+    {
+    public:
+        using NodeIndex = int32_t;
+        static constexpr NodeIndex InvalidNode = -1;
+
+        /** \brief World matrix split into its components, with the normalized basis axes */
+        struct Decomposition
+        {
+            glm::vec3 position = glm::vec3(0.0f);
+            Quaternion rotation = Quaternion();
+            glm::vec3 scale = glm::vec3(1.0f);
+
+            glm::vec3 right = glm::vec3(1.0f, 0.0f, 0.0f);
+            glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+            glm::vec3 forward = glm::vec3(0.0f, 0.0f, 1.0f);
+        };
+
+        TransformHierarchy() = default;
+        TransformHierarchy(const TransformHierarchy&) = delete;
+        TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+        /**
+         * \brief Register a transform as a new root node
+         * \param owner The transform that authors the node's local TRS
+         * \return The node index, kept up to date in the owner when the node moves
+         */
+        NodeIndex Add(Transform* owner);
+
+        /**
+         * \brief Unregister a node. Its children become roots.
+         * \param node The node to remove
+         */
+        void Remove(NodeIndex node);
+
+        /**
+         * \brief Attach a node to a new parent
+         * \param node The node to re-parent
+         * \param parent The new parent, or InvalidNode to make it a root
+         * \remark A node stored before its new parent moves to the end with its subtree
+         */
+        void SetParent(NodeIndex node, NodeIndex parent);
+
+        /** \brief Flag a node so its local TRS is read back on the next Update() */
+        void SetDirty(NodeIndex node) { m_flags[node] |= FlagDirty; }
+
+        bool IsDirty(NodeIndex node) const { return (m_flags[node] & FlagDirty) != 0; }
+        NodeIndex GetParent(NodeIndex node) const { return m_parent[node]; }
+        const Affine& GetWorld(NodeIndex node) const { return m_world[node]; }
+
+        /** \brief Incremented every time the world matrix of the node is recomputed */
+        uint32_t GetVersion(NodeIndex node) const { return m_version[node]; }
+        /** \brief Live nodes, without the holes left by removed ones */
+        size_t GetNodeCount() const { return m_owner.size() - m_free.size() - m_pendingFree.size(); }
+
+        /**
+         * \brief The decomposed world matrix of a node, as of the last Update().
+         * Computed on first access after the world matrix changed, then cached.
+         */
+        const Decomposition& GetDecomposition(NodeIndex node);
+
+        /**
+         * \brief Call func(transform) once for every live transform whose world
+         * matrix changed since the previous call, then forget them.
+         * Lets systems refresh derived data (bounds, spatial indices) only for what moved.
+         */
+        template <typename Func>
+        void ConsumeMoved(Func&& func)
+        {
+            for (NodeIndex node : m_moved)
+            {
+                m_flags[node] &= ~FlagMoved;
+                if (m_owner[node]) func(*m_owner[node]);
+            }
+            m_moved.clear();
+        }
+
+        /**
+         * \brief Compact the holes if they dominate and propagate every
+         * dirty node's world matrix down to its descendants.
+         */
+        void Update();
+
+        /** \brief The hierarchy every Transform registers into */
+        static TransformHierarchy& Main();
+
+    private:
+        enum Flags : uint8_t
+        {
+            FlagDirty = 1 << 0,      // Local TRS changed since the last update
+            FlagChanged = 1 << 1,    // World matrix was recomputed during the current sweep
+            FlagDead = 1 << 2,       // Removed, the slot is reused or compacted away
+            FlagDecomposed = 1 << 3, // Decomposition matches the world matrix
+            FlagMoved = 1 << 4,      // Listed in m_moved, until ConsumeMoved()
+        };
+
+        void Sort();
+
+        // Move a node and its subtree to new slots at the end, after any parent
+        void Relocate(NodeIndex node);
+
+        // Gather every array into m_order, dead nodes last, then drop the dead ones
+        template <typename T>
+        void ApplyOrder(std::vector<T>& values, size_t liveCount);
+
+        // Read back the authored TRS of dirty nodes and compose their local matrices
+        void ComposeDirtyLocals();
+
+        static Quaternion RotationFromBasis(const glm::vec3& right, const glm::vec3& up, const glm::vec3& forward);
+
+    private:
+        std::vector<NodeIndex> m_parent;
+        std::vector<uint32_t> m_depth;
+
+        TRSArrays m_localTRS;
+        std::vector<Affine> m_local;
+
+        std::vector<Affine> m_world;
+        std::vector<Decomposition> m_decomposition;
+        std::vector<uint8_t> m_flags;
+        std::vector<uint32_t> m_version;
+        std::vector<uint32_t> m_childCount;
+        std::vector<Transform*> m_owner;
+
+        // Removed nodes, reusable once an Update() made their children roots
+        std::vector<NodeIndex> m_pendingFree;
+        // Reusable nodes, the lowest index last so new roots tend to precede what is attached to them
+        std::vector<NodeIndex> m_free;
+
+        // Scratch of Sort() and Relocate(), kept for its capacity
+        std::vector<NodeIndex> m_order;
+        std::vector<NodeIndex> m_remap;
+        std::vector<NodeIndex> m_chain;
+        std::vector<uint32_t> m_depthStart;
+        std::vector<uint8_t> m_placed;
+
+        // Nodes whose world matrix changed since the last ConsumeMoved()
+        std::vector<NodeIndex> m_moved;
+    };
+} // namespace Vosgi
+
+#endif // !__TRANSFORM_HIERARCHY_H__
@@ -0,0 +1,52 @@
+#ifndef __UNIFORM_BLOCKS_H__
+#define __UNIFORM_BLOCKS_H__
+
+#pragma once
+
+/*
+ * Uniform blocks shared by every shader program.
+ *
+ * Data that is the same for all programs is written once per view into
+ * the stream buffer and bound to a fixed uniform buffer binding
+ * point, rather than uploaded to each program with glUniform*. Shader links
+ * the blocks of its program to these binding points by name, since GLSL 330
+ * cannot declare them in the source.
+ */
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+namespace Vosgi
+{
+    namespace UniformBlocks
+    {
+        /** \brief Binding points, and the block names they are linked to */
+        enum Binding : GLuint
+        {
+            ViewBinding = 0,
+        };
+
+        constexpr const char* ViewBlockName = "ViewData";
+
+        /** \brief std140 layout of the ViewData block */
+        struct ViewData
+        {
+            glm::mat4 view = glm::mat4(1.0f);
+            glm::mat4 projection = glm::mat4(1.0f);
+            glm::mat4 viewProjection = glm::mat4(1.0f);
+            // w unused, a vec3 is padded to 16 bytes anyway
+            glm::vec4 eyePosition = glm::vec4(0.0f);
+        };
+
+        static_assert(sizeof(ViewData) == 208, "ViewData must match its std140 layout");
+
+        /** \brief Write the view block and bind it, before the draws of each view */
+        void SetView(const ViewData& data);
+
+        /** \brief Link the blocks a program declares to their binding points, after linking it */
+        void BindProgram(GLuint program);
+    }
+} // namespace Vosgi
+
+#endif // !__UNIFORM_BLOCKS_H__
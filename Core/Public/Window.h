@@ -11,6 +11,7 @@ namespace Vosgi
     class WindowHandle
     {
     public:
+        void virtual Update(float deltaTime) {}
         void virtual Draw(float deltaTime, unsigned int &displayCount, unsigned int &drawCount, unsigned int &entityCount) {}
         void virtual KeyCallback(int key, int scancode, int action, int mods) {}
         void virtual MouseCallback(double xPos, double yPos) {}
@@ -45,6 +46,8 @@ namespace Vosgi
         virtual void SwapBuffers() = 0;
         virtual void PollEvents() = 0;
         virtual void Terminate() = 0;
+        // Stop the run loop at the end of the current frame
+        virtual void Close() = 0;
 
         virtual void CreateCallbacks() = 0;
 
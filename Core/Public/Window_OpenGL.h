@@ -22,6 +22,7 @@ namespace Vosgi
         void SwapBuffers() override;
         void PollEvents() override;
         void Terminate() override;
+        void Close() override;
 
         void SetWindowLabel(const char *label) override;
         void SetMouseEnabled(bool enabled) override;
@@ -0,0 +1,106 @@
+/*
+ * AABBTree frustum queries against FrustumCull over every box, as the
+ * number of boxes and the part of them in view grow.
+ *
+ * Boxes are scattered over a flat level and seen by a camera whose far
+ * plane sets how many of them are visible. The flat cull tests every box,
+ * so its cost follows the total; the tree rejects whole subtrees, so its
+ * cost should follow what is visible, until walking the fully visible
+ * subtrees costs more than the flat cull. The tree is timed walking every
+ * query, then switching to its leaf scan past scanFraction visible. Both
+ * must return the same proxies as the flat cull.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "AABBTree.h"
+#include "Culling.h"
+
+#include "TestCommon.h"
+
+using namespace Vosgi;
+
+namespace
+{
+    constexpr float LevelSize = 2000.0f;
+
+    // The proxy index is stored as user data, offset so that none is null
+    void* ToUserData(size_t index) { return reinterpret_cast<void*>(static_cast<uintptr_t>(index + 1)); }
+    size_t FromUserData(void* userData) { return static_cast<size_t>(reinterpret_cast<uintptr_t>(userData)) - 1; }
+
+    void Run(size_t boxCount)
+    {
+        std::mt19937 random(static_cast<uint32_t>(boxCount));
+        std::uniform_real_distribution<float> position(-LevelSize * 0.5f, LevelSize * 0.5f);
+        std::uniform_real_distribution<float> height(0.0f, 20.0f);
+        std::uniform_real_distribution<float> size(0.25f, 2.0f);
+
+        AABBTree tree;
+        BoundsArrays bounds;
+        for (size_t i = 0; i < boxCount; ++i)
+        {
+            const glm::vec3 center(position(random), height(random), position(random));
+            const glm::vec3 extents(size(random), size(random), size(random));
+            tree.CreateProxy(center - extents, center + extents, ToUserData(i));
+
+            // The tree tests its fattened boxes, so the flat cull does too
+            bounds.Add(center, extents + glm::vec3(tree.margin));
+        }
+
+        // Looking across the level from its middle, further and further away
+        const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f, 10.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        for (float farPlane : {25.0f, 100.0f, 400.0f, 1600.0f})
+        {
+            const Frustum frustum = Frustum::FromMatrix(glm::perspective(1.0f, 16.0f / 9.0f, 0.1f, farPlane) * view);
+
+            // Always walking the tree, then scanning the leaves instead once enough of them are visible
+            std::vector<void*> found;
+            Culling::PlaneStats stats;
+            const float scanFraction = tree.scanFraction;
+            tree.scanFraction = 2.0f;
+            const double walkTime = Test::Measure(10, [&] {
+                found.clear();
+                stats = tree.QueryFrustum(frustum, found);
+            });
+            std::vector<void*> walked = found;
+
+            tree.scanFraction = scanFraction;
+            const double treeTime = Test::Measure(10, [&] {
+                found.clear();
+                stats = tree.QueryFrustum(frustum, found);
+            });
+
+            VisibilityMask visibility;
+            std::vector<size_t> expected;
+            const double flatTime = Test::Measure(10, [&] {
+                Culling::FrustumCull(frustum, bounds, visibility);
+                expected.clear();
+                Culling::ForEachVisible(visibility, [&](size_t index) { expected.push_back(index); });
+            });
+
+            for (const std::vector<void*>* results : {&walked, &found})
+            {
+                std::vector<size_t> indices;
+                for (void* userData : *results) indices.push_back(FromUserData(userData));
+                std::sort(indices.begin(), indices.end());
+                VOSGI_CHECK(indices == expected);
+            }
+
+            std::printf("%8zu boxes  far %6.0f  %7zu visible (%5.2f%%)  walk %8.3f ms  query %8.3f ms, %7u box tests  flat %8.3f ms\n",
+                        boxCount, farPlane, expected.size(), 100.0 * static_cast<double>(expected.size()) / static_cast<double>(boxCount),
+                        walkTime, treeTime, stats.boxes, flatTime);
+        }
+    }
+}
+
+int main()
+{
+    for (size_t boxCount : {10000, 100000, 1000000}) Run(boxCount);
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * Multi-view frustum culling, as run by Scene::CullViews.
+ *
+ * Random boxes are culled against several views at once with
+ * MultiFrustumCull and sorted into per-view lists with GatherViews. At every
+ * SIMD level, the masks must match FrustumCull run once per view, and the
+ * lists must match a per-box reference test. The single pass is then timed
+ * against one FrustumCull per view, alone and with the gather, and
+ * GatherViews against scanning the masks once per view. There are enough
+ * boxes that their bounds do not stay in cache from one view to the next,
+ * which is what the single pass saves.
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Culling.h"
+#include "SIMD.h"
+
+#include "TestCommon.h"
+
+using namespace Vosgi;
+
+namespace
+{
+    constexpr size_t BoxCount = 300007; // not a multiple of the SIMD width, so the tails run too
+
+    enum class Side
+    {
+        Outside,
+        Inside,
+        Border // closer to a plane than rounding, where FMA and separate multiplies may disagree
+    };
+
+    // Inside or crossing every plane, the conservative test the kernels implement
+    Side Overlaps(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extents)
+    {
+        Side side = Side::Inside;
+        for (const Plane* plane : {&frustum.leftFace, &frustum.rightFace, &frustum.farFace, &frustum.nearFace, &frustum.topFace, &frustum.bottomFace})
+        {
+            const glm::vec3& n = plane->normal;
+            const float radius = extents.x * std::abs(n.x) + extents.y * std::abs(n.y) + extents.z * std::abs(n.z);
+            const float distance = plane->getSignedDistanceToPlane(center) + radius;
+            if (distance < -1e-3f) return Side::Outside;
+            if (distance < 1e-3f) side = Side::Border;
+        }
+        return side;
+    }
+
+    // Views looking down -Z and +Z from a few points, with different fields of view
+    std::vector<Frustum> MakeViews(size_t count)
+    {
+        std::vector<Frustum> frustums;
+        for (size_t view = 0; view < count; ++view)
+        {
+            const glm::vec3 eye(static_cast<float>(view % 4) * 100.0f - 150.0f, 0.0f, static_cast<float>(view / 4) * 50.0f);
+            const float flip = view % 2 == 0 ? 1.0f : -1.0f;
+            const glm::mat4 projection = glm::perspective(0.6f + 0.1f * static_cast<float>(view % 5), 16.0f / 9.0f, 0.1f, 400.0f);
+            const glm::mat4 viewMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 1.0f, flip)) * glm::translate(glm::mat4(1.0f), -eye);
+            frustums.push_back(Frustum::FromMatrix(projection * viewMatrix));
+        }
+        return frustums;
+    }
+}
+
+int main()
+{
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.1f, 5.0f);
+
+    BoundsArrays bounds;
+    std::vector<size_t> objects;
+    for (size_t i = 0; i < BoxCount; ++i)
+    {
+        bounds.Add(glm::vec3(position(random), position(random) * 0.1f, position(random)), glm::vec3(size(random), size(random), size(random)));
+        objects.push_back(i);
+    }
+
+    for (size_t viewCount : {size_t(1), size_t(2), size_t(4), size_t(6), Culling::MaxViews})
+    {
+        const std::vector<Frustum> frustums = MakeViews(viewCount);
+
+        for (int level = 0; level <= static_cast<int>(SIMD::GetSupportedLevel()); ++level)
+        {
+            SIMD::SetLevel(static_cast<SIMD::Level>(level));
+
+            std::vector<ViewMask> views;
+            std::vector<std::vector<size_t>> lists;
+            const double singleCull = Test::Measure(10, [&] { Culling::MultiFrustumCull(frustums.data(), viewCount, bounds, views); });
+            const double single = Test::Measure(10, [&] {
+                Culling::MultiFrustumCull(frustums.data(), viewCount, bounds, views);
+                Culling::GatherViews(views, objects, viewCount, lists);
+            });
+
+            VisibilityMask visibility;
+            const double perViewCull = Test::Measure(10, [&] {
+                for (size_t view = 0; view < viewCount; ++view) Culling::FrustumCull(frustums[view], bounds, visibility);
+            });
+            std::vector<std::vector<size_t>> perViewLists(viewCount);
+            const double perView = Test::Measure(10, [&] {
+                for (size_t view = 0; view < viewCount; ++view)
+                {
+                    Culling::FrustumCull(frustums[view], bounds, visibility);
+                    perViewLists[view].clear();
+                    Culling::ForEachVisible(visibility, [&](size_t index) { perViewLists[view].push_back(objects[index]); });
+                }
+            });
+
+            // Both passes agree with each other and with the reference test
+            VOSGI_CHECK(views.size() == BoxCount);
+            VOSGI_CHECK(lists.size() == viewCount);
+            for (size_t view = 0; view < viewCount; ++view)
+            {
+                VOSGI_CHECK(lists[view] == perViewLists[view]);
+
+                std::vector<size_t> expected;
+                for (size_t i = 0; i < BoxCount; ++i)
+                {
+                    const Side side = Overlaps(frustums[view], glm::vec3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]),
+                                               glm::vec3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]));
+                    const bool seen = (views[i] >> view) & 1;
+                    if (side != Side::Border) VOSGI_CHECK(seen == (side == Side::Inside));
+                    if (seen) expected.push_back(i);
+                }
+                VOSGI_CHECK(lists[view] == expected);
+                VOSGI_CHECK(!expected.empty());
+            }
+
+            // The gather alone, against one scan of the masks per view
+            const double gather = Test::Measure(10, [&] { Culling::GatherViews(views, objects, viewCount, lists); });
+            const double scans = Test::Measure(10, [&] {
+                for (size_t view = 0; view < viewCount; ++view)
+                {
+                    perViewLists[view].clear();
+                    for (size_t i = 0; i < views.size(); ++i)
+                    {
+                        if (views[i] & (ViewMask(1) << view)) perViewLists[view].push_back(objects[i]);
+                    }
+                }
+            });
+
+            std::printf("%2zu views %-6s  cull: single pass %7.3f ms, per view %7.3f ms  with lists: %7.3f ms, %7.3f ms  gather %7.3f ms, scan per view %7.3f ms\n",
+                        viewCount, SIMD::GetLevelName(SIMD::GetLevel()), singleCull, perViewCull, single, perView, gather, scans);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * Flat TransformHierarchy sweep against the recursive per-entity update it replaced.
+ *
+ * Both sides hold the same forest of fanout-4 trees, five levels deep, and
+ * are timed on a full update (every node moved) and on a sparse one (1% of
+ * the nodes moved, the common frame). The recursive side reproduces the old
+ * Entity::UpdateSelfAndChildren: a translate * rotate * scale mat4 per node
+ * and a full mat4 product with the parent, visiting every node to find the
+ * dirty ones. The world matrices of both sides are compared at the end.
+ *
+ * A churn run then destroys, spawns and reparents a few percent of the nodes
+ * every frame, like a running game, and checks the world matrices against
+ * the product of the local matrices up each parent chain.
+ */
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Transform.h"
+#include "TransformHierarchy.h"
+
+#include "TestCommon.h"
+
+using namespace Vosgi;
+
+namespace
+{
+    constexpr size_t Fanout = 4;
+
+    struct RecursiveNode
+    {
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 scale = glm::vec3(1.0f);
+        glm::mat4 model = glm::mat4(1.0f);
+        bool dirty = true;
+
+        RecursiveNode* parent = nullptr;
+        std::vector<RecursiveNode*> children;
+
+        glm::mat4 GetLocal() const
+        {
+            return glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+        }
+
+        void ForceUpdate()
+        {
+            model = parent ? parent->model * GetLocal() : GetLocal();
+            dirty = false;
+            for (RecursiveNode* child : children) child->ForceUpdate();
+        }
+
+        void Update()
+        {
+            if (dirty)
+            {
+                ForceUpdate();
+                return;
+            }
+            for (RecursiveNode* child : children) child->Update();
+        }
+    };
+
+    struct Pose
+    {
+        glm::vec3 position;
+        glm::quat rotation;
+        glm::vec3 scale;
+    };
+
+    Pose RandomPose(std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> size(0.5f, 1.5f);
+
+        glm::quat rotation(unit(random), unit(random), unit(random), unit(random));
+        const float length = std::sqrt(glm::dot(rotation, rotation));
+        rotation = glm::quat(rotation.w / length, rotation.x / length, rotation.y / length, rotation.z / length);
+
+        return {glm::vec3(offset(random), offset(random), offset(random)), rotation, glm::vec3(size(random))};
+    }
+
+    void Run(size_t nodeCount)
+    {
+        std::mt19937 random(static_cast<uint32_t>(nodeCount));
+
+        // Node i > 0 of a tree hangs under node (i - 1) / Fanout, 1365 nodes per tree
+        const size_t treeSize = 1 + Fanout + Fanout * Fanout + Fanout * Fanout * Fanout + Fanout * Fanout * Fanout * Fanout + Fanout * Fanout * Fanout * Fanout * Fanout;
+
+        std::vector<RecursiveNode> recursive(nodeCount);
+        std::vector<RecursiveNode*> roots;
+        std::vector<std::unique_ptr<Transform>> flat;
+        flat.reserve(nodeCount);
+
+        for (size_t i = 0; i < nodeCount; ++i)
+        {
+            const Pose pose = RandomPose(random);
+            recursive[i].position = pose.position;
+            recursive[i].rotation = pose.rotation;
+            recursive[i].scale = pose.scale;
+
+            flat.push_back(std::make_unique<Transform>());
+            flat[i]->SetPosition(pose.position);
+            flat[i]->SetRotation(pose.rotation);
+            flat[i]->SetLocalScale(pose.scale);
+
+            const size_t local = i % treeSize;
+            if (local == 0)
+            {
+                roots.push_back(&recursive[i]);
+                continue;
+            }
+
+            const size_t parent = i - local + (local - 1) / Fanout;
+            recursive[i].parent = &recursive[parent];
+            recursive[parent].children.push_back(&recursive[i]);
+            flat[i]->SetParent(flat[parent].get());
+        }
+
+        TransformHierarchy& hierarchy = TransformHierarchy::Main();
+        hierarchy.Update();
+        for (RecursiveNode* root : roots) root->Update();
+
+        // Full: every node moved
+        const double recursiveFull = Test::Measure(10, [&] {
+            for (RecursiveNode& node : recursive) node.dirty = true;
+            for (RecursiveNode* root : roots) root->Update();
+        });
+        const double flatFull = Test::Measure(10, [&] {
+            for (auto& transform : flat) transform->SetDirty();
+            hierarchy.Update();
+        });
+
+        // Sparse: the same 1% of the nodes moved every frame
+        std::vector<size_t> moved;
+        for (size_t i = 0; i < nodeCount; i += 100) moved.push_back((i * 7919) % nodeCount);
+
+        const double recursiveSparse = Test::Measure(20, [&] {
+            for (size_t i : moved) recursive[i].dirty = true;
+            for (RecursiveNode* root : roots) root->Update();
+        });
+        const double flatSparse = Test::Measure(20, [&] {
+            for (size_t i : moved) flat[i]->SetDirty();
+            hierarchy.Update();
+        });
+
+        // Both sides must agree on every world matrix
+        float maxError = 0.0f;
+        for (size_t i = 0; i < nodeCount; ++i)
+        {
+            const glm::mat4 world = flat[i]->GetModel().ToMat4();
+            for (int column = 0; column < 4; ++column)
+            {
+                for (int row = 0; row < 4; ++row)
+                {
+                    const float reference = recursive[i].model[column][row];
+                    maxError = std::max(maxError, std::abs(world[column][row] - reference) / std::max(1.0f, std::abs(reference)));
+                }
+            }
+        }
+        VOSGI_CHECK(maxError < 1e-3f);
+
+        std::printf("%7zu nodes  full: recursive %8.3f ms, flat %8.3f ms (%.1fx)  sparse: recursive %8.3f ms, flat %8.3f ms (%.1fx)\n",
+                    nodeCount, recursiveFull, flatFull, recursiveFull / flatFull, recursiveSparse, flatSparse, recursiveSparse / flatSparse);
+    }
+
+    glm::mat4 ToMat4(const Pose& pose)
+    {
+        return glm::translate(glm::mat4(1.0f), pose.position) * glm::mat4_cast(pose.rotation) * glm::scale(glm::mat4(1.0f), pose.scale);
+    }
+
+    void Churn(size_t nodeCount, size_t frameCount)
+    {
+        constexpr size_t NoParent = static_cast<size_t>(-1);
+        std::mt19937 random(11);
+
+        std::vector<std::unique_ptr<Transform>> flat(nodeCount);
+        std::vector<Pose> poses(nodeCount);
+        std::vector<size_t> parents(nodeCount, NoParent);
+        std::vector<uint32_t> generations(nodeCount, 0), parentGenerations(nodeCount, 0);
+
+        // Children of a destroyed node become roots
+        const auto parentOf = [&](size_t i) {
+            const size_t parent = parents[i];
+            return parent != NoParent && generations[parent] == parentGenerations[i] ? parent : NoParent;
+        };
+
+        const auto spawn = [&](size_t i) {
+            poses[i] = RandomPose(random);
+            flat[i] = std::make_unique<Transform>();
+            flat[i]->SetPosition(poses[i].position);
+            flat[i]->SetRotation(poses[i].rotation);
+            flat[i]->SetLocalScale(poses[i].scale);
+            parents[i] = NoParent;
+            ++generations[i];
+        };
+        const auto reparent = [&](size_t i, size_t parent) {
+            // The hierarchy refuses cycles, and so does the reference
+            for (size_t ancestor = parent; ancestor != NoParent; ancestor = parentOf(ancestor))
+            {
+                if (ancestor == i) return;
+            }
+            flat[i]->SetParent(flat[parent].get());
+            parents[i] = parent;
+            parentGenerations[i] = generations[parent];
+        };
+
+        for (size_t i = 0; i < nodeCount; ++i) spawn(i);
+        for (size_t i = 1; i < nodeCount; ++i) reparent(i, random() % i);
+
+        TransformHierarchy& hierarchy = TransformHierarchy::Main();
+        hierarchy.Update();
+
+        const size_t changes = nodeCount / 50;
+        const double frame = Test::Measure(static_cast<int>(frameCount), [&] {
+            for (size_t k = 0; k < changes; ++k)
+            {
+                const size_t destroyed = random() % nodeCount;
+                flat[destroyed].reset();
+                spawn(destroyed);
+
+                reparent(random() % nodeCount, random() % nodeCount);
+                reparent(destroyed, random() % nodeCount);
+            }
+            hierarchy.Update();
+        });
+
+        VOSGI_CHECK(hierarchy.GetNodeCount() == nodeCount);
+
+        std::vector<glm::mat4> reference(nodeCount);
+        std::vector<bool> resolved(nodeCount, false);
+        float maxError = 0.0f;
+        for (size_t i = 0; i < nodeCount; ++i)
+        {
+            std::vector<size_t> chain;
+            for (size_t node = i; node != NoParent && !resolved[node]; node = parentOf(node)) chain.push_back(node);
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+            {
+                const size_t parent = parentOf(*it);
+                reference[*it] = parent != NoParent ? reference[parent] * ToMat4(poses[*it]) : ToMat4(poses[*it]);
+                resolved[*it] = true;
+            }
+
+            const glm::mat4 world = flat[i]->GetModel().ToMat4();
+            for (int column = 0; column < 4; ++column)
+            {
+                for (int row = 0; row < 4; ++row)
+                {
+                    maxError = std::max(maxError, std::abs(world[column][row] - reference[i][column][row]) / std::max(1.0f, std::abs(reference[i][column][row])));
+                }
+            }
+        }
+        VOSGI_CHECK(maxError < 1e-3f);
+
+        std::printf("%7zu nodes  churn: %zu destroyed, spawned and reparented per frame %8.3f ms\n", nodeCount, changes, frame);
+    }
+}
+
+int main()
+{
+    for (size_t nodeCount : {1000, 10000, 100000})
+    {
+        Run(nodeCount);
+
+        // The transforms of this size are gone, recycle their slots before the next one
+        TransformHierarchy::Main().Update();
+    }
+    Churn(10000, 50);
+    return 0;
+}
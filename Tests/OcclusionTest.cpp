@@ -0,0 +1,153 @@
+/*
+ * OcclusionBuffer against synthetic occluders, then timed on a city block.
+ *
+ * A single wall must hide the boxes behind it and nothing else. The city is
+ * a grid of buildings seen from street level with props scattered between
+ * them: every SIMD level and thread count must rasterize the same depth and
+ * agree on which props are visible, and the rasterization and the queries
+ * are timed for each.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Affine.h"
+#include "OcclusionBuffer.h"
+#include "SIMD.h"
+
+#include "TestCommon.h"
+
+using namespace Vosgi;
+
+namespace
+{
+    constexpr uint32_t Width = 320;
+    constexpr uint32_t Height = 180;
+
+    // Unit cube from -1 to 1, counter-clockwise seen from outside
+    const glm::vec3 CubePositions[] = {{-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1}, {-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1}};
+    const uint32_t CubeIndices[] = {4, 5, 6, 4, 6, 7, 1, 0, 3, 1, 3, 2, 5, 1, 2, 5, 2, 6,
+                                    0, 4, 7, 0, 7, 3, 7, 6, 2, 7, 2, 3, 0, 1, 5, 0, 5, 4};
+
+    Affine Box(const glm::vec3& center, const glm::vec3& extents)
+    {
+        return Affine(glm::vec4(extents.x, 0, 0, center.x), glm::vec4(0, extents.y, 0, center.y), glm::vec4(0, 0, extents.z, center.z));
+    }
+
+    void AddBox(OcclusionBuffer& buffer, const Affine& box)
+    {
+        buffer.AddOccluder(CubePositions, sizeof(glm::vec3), CubeIndices, std::size(CubeIndices), box);
+    }
+
+    // Camera at eye looking down -Z
+    glm::mat4 ViewProjection(const glm::vec3& eye)
+    {
+        return glm::perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f) * glm::translate(glm::mat4(1.0f), -eye);
+    }
+
+    void TestWall()
+    {
+        OcclusionBuffer buffer(Width, Height, 4);
+        buffer.Begin(ViewProjection(glm::vec3(0.0f, 2.0f, 0.0f)));
+        AddBox(buffer, Box(glm::vec3(0.0f, 2.0f, -10.0f), glm::vec3(5.0f, 5.0f, 0.5f)));
+        buffer.Rasterize();
+
+        // The front face, and the sides seen at an angle, the rest faces away
+        VOSGI_CHECK(buffer.GetRasterizedCount() >= 2 && buffer.GetRasterizedCount() <= 6);
+
+        VOSGI_CHECK(!buffer.IsVisible(glm::vec3(0.0f, 2.0f, -20.0f), glm::vec3(1.0f))); // behind the wall
+        VOSGI_CHECK(buffer.IsVisible(glm::vec3(0.0f, 2.0f, -5.0f), glm::vec3(1.0f)));   // in front of it
+        VOSGI_CHECK(buffer.IsVisible(glm::vec3(30.0f, 2.0f, -20.0f), glm::vec3(1.0f))); // beside it
+        VOSGI_CHECK(buffer.IsVisible(glm::vec3(0.0f, 2.0f, -20.0f), glm::vec3(10.0f, 10.0f, 1.0f))); // larger than it
+        VOSGI_CHECK(buffer.IsVisible(glm::vec3(0.0f, 2.0f, 1.0f), glm::vec3(1.0f)));    // around the camera
+    }
+
+    void TestEmpty()
+    {
+        // Nothing rasterized hides nothing
+        OcclusionBuffer buffer(Width, Height, 1);
+        buffer.Begin(ViewProjection(glm::vec3(0.0f)));
+        buffer.Rasterize();
+
+        VOSGI_CHECK(buffer.GetRasterizedCount() == 0);
+        VOSGI_CHECK(buffer.IsVisible(glm::vec3(0.0f, 0.0f, -500.0f), glm::vec3(0.1f)));
+    }
+
+    void BenchmarkCity()
+    {
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> height(5.0f, 30.0f);
+        std::uniform_real_distribution<float> across(-200.0f, 200.0f);
+        std::uniform_real_distribution<float> ahead(-400.0f, -5.0f);
+
+        // 21 x 20 blocks of 14 x 14 buildings on a 20 unit grid
+        std::vector<Affine> buildings;
+        for (int x = -10; x <= 10; ++x)
+        {
+            for (int z = 1; z <= 20; ++z) buildings.push_back(Box(glm::vec3(x * 20.0f, 0.0f, z * -20.0f), glm::vec3(7.0f, height(random), 7.0f)));
+        }
+
+        std::vector<glm::vec3> props;
+        for (int i = 0; i < 20000; ++i) props.emplace_back(across(random), 1.0f, ahead(random));
+        const glm::vec3 propExtents(0.5f, 1.0f, 0.5f);
+
+        const glm::mat4 viewProjection = ViewProjection(glm::vec3(0.0f, 2.0f, 0.0f));
+
+        std::vector<float> referenceDepth;
+        std::vector<bool> referenceVisible;
+        for (int level = 0; level <= static_cast<int>(SIMD::GetSupportedLevel()); ++level)
+        {
+            SIMD::SetLevel(static_cast<SIMD::Level>(level));
+            for (uint32_t threads : {1u, 4u})
+            {
+                OcclusionBuffer buffer(Width, Height, threads);
+                const double rasterize = Test::Measure(20, [&] {
+                    buffer.Begin(viewProjection);
+                    for (const Affine& building : buildings) AddBox(buffer, building);
+                    buffer.Rasterize();
+                });
+
+                std::vector<bool> visible(props.size());
+                const double query = Test::Measure(5, [&] {
+                    for (size_t i = 0; i < props.size(); ++i) visible[i] = buffer.IsVisible(props[i], propExtents);
+                });
+
+                // Every level and thread count must agree with the first
+                if (referenceDepth.empty())
+                {
+                    referenceDepth = buffer.GetDepth();
+                    referenceVisible = visible;
+                }
+                float maxDifference = 0.0f;
+                for (size_t i = 0; i < referenceDepth.size(); ++i)
+                {
+                    if (i % buffer.GetStride() < buffer.GetWidth()) maxDifference = std::max(maxDifference, std::abs(referenceDepth[i] - buffer.GetDepth()[i]));
+                }
+                VOSGI_CHECK(maxDifference < 1e-5f);
+                VOSGI_CHECK(visible == referenceVisible);
+
+                // Most of the street is hidden behind the first rows of buildings
+                const size_t visibleCount = std::count(visible.begin(), visible.end(), true);
+                VOSGI_CHECK(visibleCount > 0 && visibleCount < props.size() / 2);
+
+                std::printf("%-6s %u thread(s)  rasterize %7.1f us (%zu triangles)  %zu queries %7.1f us, %zu visible\n",
+                            SIMD::GetLevelName(SIMD::GetLevel()), threads, rasterize * 1000.0, buffer.GetRasterizedCount(), props.size(),
+                            query * 1000.0, visibleCount);
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestWall();
+    TestEmpty();
+    BenchmarkCity();
+    return 0;
+}
@@ -0,0 +1,234 @@
+/*
+ * LooseOctree queries against a brute-force scan of the same boxes.
+ *
+ * 200k entries, mostly small with a few large ones and some points, are
+ * inserted, then moved, removed and reinserted like a running game would.
+ * Sphere, box and ray queries are then timed on both sides, and the octree
+ * must return exactly what the scan finds. Half of the rays are parallel to
+ * an axis and start on the faces of the boxes, where slab tests divide by
+ * zero.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "LooseOctree.h"
+
+#include "TestCommon.h"
+
+using namespace Vosgi;
+
+namespace
+{
+    constexpr uint32_t EntryCount = 200000;
+    constexpr int QueryCount = 100;
+    constexpr float RayLength = 3000.0f;
+
+    struct Scene
+    {
+        LooseOctree octree = LooseOctree(glm::vec3(0.0f), 2048.0f, 8);
+        std::vector<AABB> bounds;
+        std::vector<LooseOctree::EntryId> entries;
+        std::vector<bool> alive;
+
+        void Insert(uint32_t i)
+        {
+            entries[i] = octree.Insert(EntityHandle(i, 1), bounds[i]);
+            alive[i] = true;
+        }
+    };
+
+    // Sorted indices of the alive entries passing the test
+    template <typename Test>
+    std::vector<uint32_t> BruteForce(const Scene& scene, Test&& test)
+    {
+        std::vector<uint32_t> found;
+        for (uint32_t i = 0; i < EntryCount; ++i)
+        {
+            if (scene.alive[i] && test(scene.bounds[i])) found.push_back(i);
+        }
+        return found;
+    }
+
+    std::vector<uint32_t> Sorted(const std::vector<EntityHandle>& handles)
+    {
+        std::vector<uint32_t> indices;
+        for (EntityHandle handle : handles) indices.push_back(handle.GetIndex());
+        std::sort(indices.begin(), indices.end());
+        return indices;
+    }
+
+    // Entry distance of the ray into the box, or a negative value on a miss, one axis at a time
+    float IntersectRay(const AABB& box, const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+    {
+        float enter = 0.0f;
+        float exit = maxDistance;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float low = box.center[axis] - box.extents[axis] - origin[axis];
+            const float high = box.center[axis] + box.extents[axis] - origin[axis];
+            if (direction[axis] == 0.0f)
+            {
+                if (low > 0.0f || high < 0.0f) return -1.0f;
+                continue;
+            }
+            const float t0 = low / direction[axis];
+            const float t1 = high / direction[axis];
+            enter = std::max(enter, std::min(t0, t1));
+            exit = std::min(exit, std::max(t0, t1));
+        }
+        return enter <= exit ? enter : -1.0f;
+    }
+}
+
+int main()
+{
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> size(0.0f, 4.0f);
+
+    Scene scene;
+    scene.bounds.resize(EntryCount);
+    scene.entries.resize(EntryCount);
+    scene.alive.resize(EntryCount);
+
+    for (uint32_t i = 0; i < EntryCount; ++i)
+    {
+        float extent = i % 100 == 0 ? size(random) * 50.0f : size(random);
+        if (i % 7 == 0) extent = 0.0f;
+
+        // A few entries outside the root cell, kept in the root
+        const float spread = i % 1000 == 0 ? 3.0f : 1.0f;
+        scene.bounds[i] = AABB(glm::vec3(position(random), position(random), position(random)) * spread, extent, extent, extent);
+    }
+
+    const double insert = Test::Measure(1, [&] {
+        for (uint32_t i = 0; i < EntryCount; ++i) scene.Insert(i);
+    });
+
+    // Mostly small moves, some teleports, removals and reinsertions
+    constexpr int UpdateCount = 200000;
+    const double update = Test::Measure(1, [&] {
+        for (int k = 0; k < UpdateCount; ++k)
+        {
+            const uint32_t i = random() % EntryCount;
+            if (!scene.alive[i])
+            {
+                scene.Insert(i);
+                continue;
+            }
+            if (random() % 20 == 0)
+            {
+                scene.octree.Remove(scene.entries[i]);
+                scene.alive[i] = false;
+                continue;
+            }
+
+            scene.bounds[i].center += glm::vec3(position(random), position(random), position(random)) * 0.001f;
+            if (random() % 50 == 0) scene.bounds[i].center = glm::vec3(position(random), position(random), position(random));
+            scene.octree.Update(scene.entries[i], scene.bounds[i]);
+        }
+    });
+
+    VOSGI_CHECK(scene.octree.GetCount() == static_cast<size_t>(std::count(scene.alive.begin(), scene.alive.end(), true)));
+    std::printf("%u entries  insert %.1f ns, update %.1f ns per operation\n", EntryCount, insert * 1e6 / EntryCount, update * 1e6 / UpdateCount);
+
+    std::vector<EntityHandle> found;
+    for (float radius : {10.0f, 50.0f, 200.0f})
+    {
+        double octreeTime = 0.0, bruteTime = 0.0;
+        size_t hits = 0;
+        for (int query = 0; query < QueryCount; ++query)
+        {
+            const glm::vec3 center(position(random), position(random), position(random));
+
+            found.clear();
+            octreeTime += Test::Measure(1, [&] { scene.octree.QuerySphere(center, radius, found); });
+
+            std::vector<uint32_t> expected;
+            bruteTime += Test::Measure(1, [&] {
+                expected = BruteForce(scene, [&](const AABB& box) {
+                    const glm::vec3 offset = glm::min(glm::max(center, box.center - box.extents), box.center + box.extents) - center;
+                    return glm::dot(offset, offset) <= radius * radius;
+                });
+            });
+
+            VOSGI_CHECK(Sorted(found) == expected);
+            hits += expected.size();
+        }
+        std::printf("sphere r=%3.0f  %6.1f hits  octree %8.2f us, brute force %8.2f us\n", radius, static_cast<double>(hits) / QueryCount,
+                    octreeTime * 1000.0 / QueryCount, bruteTime * 1000.0 / QueryCount);
+    }
+
+    {
+        double octreeTime = 0.0, bruteTime = 0.0;
+        for (int query = 0; query < QueryCount; ++query)
+        {
+            const AABB box(glm::vec3(position(random), position(random), position(random)), 30.0f, 10.0f, 60.0f);
+
+            found.clear();
+            octreeTime += Test::Measure(1, [&] { scene.octree.QueryBox(box, found); });
+
+            std::vector<uint32_t> expected;
+            bruteTime += Test::Measure(1, [&] {
+                expected = BruteForce(scene, [&](const AABB& other) {
+                    const glm::vec3 distance = glm::abs(other.center - box.center);
+                    const glm::vec3 reach = other.extents + box.extents;
+                    return distance.x <= reach.x && distance.y <= reach.y && distance.z <= reach.z;
+                });
+            });
+
+            VOSGI_CHECK(Sorted(found) == expected);
+        }
+        std::printf("box           octree %8.2f us, brute force %8.2f us\n", octreeTime * 1000.0 / QueryCount, bruteTime * 1000.0 / QueryCount);
+    }
+
+    {
+        double octreeTime = 0.0, bruteTime = 0.0;
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        for (int query = 0; query < QueryCount; ++query)
+        {
+            glm::vec3 origin(position(random), position(random), position(random));
+            glm::vec3 direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)));
+
+            // Along an axis, from a point on the corner edge of an alive box
+            if (query % 2 == 1)
+            {
+                uint32_t i = random() % EntryCount;
+                while (!scene.alive[i]) i = random() % EntryCount;
+
+                const int axis = query / 2 % 3;
+                direction = glm::vec3(0.0f);
+                direction[axis] = 1.0f;
+                origin = scene.bounds[i].center - scene.bounds[i].extents;
+                origin[axis] -= 10.0f;
+            }
+
+            LooseOctree::RayHit hit;
+            bool hitFound = false;
+            octreeTime += Test::Measure(1, [&] { hitFound = scene.octree.Raycast(origin, direction, RayLength, hit); });
+
+            float nearest = RayLength;
+            bool expected = false;
+            bruteTime += Test::Measure(1, [&] {
+                for (uint32_t i = 0; i < EntryCount; ++i)
+                {
+                    if (!scene.alive[i]) continue;
+                    const float distance = IntersectRay(scene.bounds[i], origin, direction, nearest);
+                    if (distance < 0.0f) continue;
+                    nearest = distance;
+                    expected = true;
+                }
+            });
+
+            VOSGI_CHECK(hitFound == expected);
+            VOSGI_CHECK(!expected || std::abs(hit.distance - nearest) < 1e-3f);
+        }
+        std::printf("ray           octree %8.2f us, brute force %8.2f us\n", octreeTime * 1000.0 / QueryCount, bruteTime * 1000.0 / QueryCount);
+    }
+    return 0;
+}
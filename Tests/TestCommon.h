@@ -0,0 +1,49 @@
+#ifndef __TEST_COMMON_H__
+#define __TEST_COMMON_H__
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+/*
+ * Helpers shared by the headless benchmarks and tests.
+ *
+ * Checks stay on in release builds, where the timings are meaningful, and
+ * stop the program with a non-zero exit code so ctest reports the failure.
+ */
+
+#define VOSGI_CHECK(condition)                                                                     \
+    do                                                                                             \
+    {                                                                                              \
+        if (!(condition))                                                                          \
+        {                                                                                          \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);     \
+            std::exit(EXIT_FAILURE);                                                               \
+        }                                                                                          \
+    } while (0)
+
+namespace Vosgi
+{
+    namespace Test
+    {
+        /** \brief Best time of func() over a number of runs, in milliseconds */
+        template <typename Func>
+        double Measure(int runs, Func&& func)
+        {
+            double best = 1e30;
+            for (int run = 0; run < runs; ++run)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                func();
+                const auto end = std::chrono::steady_clock::now();
+                best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+            }
+            return best;
+        }
+    }
+} // namespace Vosgi
+
+#endif // !__TEST_COMMON_H__
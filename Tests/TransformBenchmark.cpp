@@ -0,0 +1,184 @@
+/*
+ * SIMD transform kernels at every level the CPU supports, against the
+ * per-element code they replace.
+ *
+ * The quaternion batch operations are compared with Quaternion, one element
+ * at a time, and Slerp with the textbook acos / sin form. ComposeTRS is
+ * compared with the old translate * rotate * scale product of three mat4.
+ * Every level is checked against the references before it is timed.
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Affine.h"
+#include "Quaternion.h"
+#include "SIMD.h"
+#include "TransformBatch.h"
+
+#include "TestCommon.h"
+
+using namespace Vosgi;
+
+namespace
+{
+    constexpr size_t Count = 100003; // not a multiple of the SIMD width, so the tails run too
+    constexpr int Runs = 20;
+
+    struct QuaternionArrays
+    {
+        std::vector<float> x, y, z, w;
+
+        explicit QuaternionArrays(size_t count) : x(count), y(count), z(count), w(count) {}
+
+        QuaternionStream Stream() { return {x.data(), y.data(), z.data(), w.data()}; }
+        Quaternion At(size_t i) const { return Quaternion(x[i], y[i], z[i], w[i]); }
+        void Set(size_t i, const Quaternion& q) { x[i] = q.x, y[i] = q.y, z[i] = q.z, w[i] = q.w; }
+    };
+
+    float Distance(const Quaternion& a, const Quaternion& b)
+    {
+        return std::abs(a.x - b.x) + std::abs(a.y - b.y) + std::abs(a.z - b.z) + std::abs(a.w - b.w);
+    }
+
+    Quaternion ReferenceSlerp(const Quaternion& from, Quaternion to, float t)
+    {
+        double cosine = Quaternion::Dot(from, to);
+        if (cosine < 0.0)
+        {
+            to = Quaternion(-to.x, -to.y, -to.z, -to.w);
+            cosine = -cosine;
+        }
+
+        const double angle = std::acos(std::min(cosine, 1.0));
+        const double sine = std::sin(angle);
+        const double a = sine < 1e-7 ? 1.0 - t : std::sin((1.0 - t) * angle) / sine;
+        const double b = sine < 1e-7 ? t : std::sin(t * angle) / sine;
+        return Quaternion(static_cast<float>(from.x * a + to.x * b), static_cast<float>(from.y * a + to.y * b),
+                          static_cast<float>(from.z * a + to.z * b), static_cast<float>(from.w * a + to.w * b));
+    }
+
+    glm::mat4 Product(const glm::mat4& a, const glm::mat4& b)
+    {
+        glm::mat4 result;
+        for (int column = 0; column < 4; ++column)
+        {
+            result[column] = a[0] * b[column][0] + a[1] * b[column][1] + a[2] * b[column][2] + a[3] * b[column][3];
+        }
+        return result;
+    }
+
+    // The per-object path ComposeTRS replaced
+    glm::mat4 ReferenceTRS(const TRSArrays& trs, size_t i)
+    {
+        const float x = trs.rotationX[i], y = trs.rotationY[i], z = trs.rotationZ[i], w = trs.rotationW[i];
+
+        glm::mat4 translate(1.0f);
+        translate[3] = glm::vec4(trs.positionX[i], trs.positionY[i], trs.positionZ[i], 1.0f);
+
+        glm::mat4 rotate(1.0f);
+        rotate[0] = glm::vec4(1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y), 0);
+        rotate[1] = glm::vec4(2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x), 0);
+        rotate[2] = glm::vec4(2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y), 0);
+
+        glm::mat4 scale(1.0f);
+        scale[0][0] = trs.scaleX[i], scale[1][1] = trs.scaleY[i], scale[2][2] = trs.scaleZ[i];
+
+        return Product(Product(translate, rotate), scale);
+    }
+
+    double PerElement(double ms) { return ms * 1e6 / Count; }
+}
+
+int main()
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> fraction(0.0f, 1.0f);
+
+    QuaternionArrays from(Count), to(Count), result(Count);
+    std::vector<float> t(Count), pointX(Count), pointY(Count), pointZ(Count), outX(Count), outY(Count), outZ(Count);
+    std::vector<Affine> matrices(Count);
+
+    TRSArrays trs;
+    trs.ForEachArray([](std::vector<float>& array) { array.resize(Count); });
+
+    for (size_t i = 0; i < Count; ++i)
+    {
+        from.Set(i, Quaternion(unit(random), unit(random), unit(random), unit(random)).normalized());
+        to.Set(i, Quaternion(unit(random), unit(random), unit(random), unit(random)).normalized());
+        t[i] = fraction(random);
+        pointX[i] = unit(random), pointY[i] = unit(random), pointZ[i] = unit(random);
+
+        const Quaternion rotation = to.At(i);
+        trs.rotationX[i] = rotation.x, trs.rotationY[i] = rotation.y, trs.rotationZ[i] = rotation.z, trs.rotationW[i] = rotation.w;
+        trs.positionX[i] = unit(random), trs.positionY[i] = unit(random), trs.positionZ[i] = unit(random);
+        trs.scaleX[i] = unit(random) + 2.0f, trs.scaleY[i] = unit(random) + 2.0f, trs.scaleZ[i] = unit(random) + 2.0f;
+    }
+
+    // References, one element at a time, writing whole results like the batch operations do
+    volatile float sink = 0.0f;
+    const double referenceMultiply = Test::Measure(Runs, [&] {
+        for (size_t i = 0; i < Count; ++i) result.Set(i, Quaternion::Multiply(from.At(i), to.At(i)));
+    });
+    const double referenceSlerp = Test::Measure(Runs, [&] {
+        for (size_t i = 0; i < Count; ++i) sink = sink + ReferenceSlerp(from.At(i), to.At(i), t[i]).x;
+    });
+    const double referenceRotate = Test::Measure(Runs, [&] {
+        for (size_t i = 0; i < Count; ++i)
+        {
+            const glm::vec3 point = Quaternion::Multiply(to.At(i), glm::vec3(pointX[i], pointY[i], pointZ[i]));
+            outX[i] = point.x, outY[i] = point.y, outZ[i] = point.z;
+        }
+    });
+    std::vector<glm::mat4> referenceMatrices(Count);
+    const double referenceCompose = Test::Measure(Runs, [&] {
+        for (size_t i = 0; i < Count; ++i) referenceMatrices[i] = ReferenceTRS(trs, i);
+    });
+
+    std::printf("%zu elements, ns per element\n", Count);
+    std::printf("%-10s multiply %6.2f  slerp %6.2f  rotate %6.2f  compose %6.2f\n", "reference",
+                PerElement(referenceMultiply), PerElement(referenceSlerp), PerElement(referenceRotate), PerElement(referenceCompose));
+
+    for (int level = 0; level <= static_cast<int>(SIMD::GetSupportedLevel()); ++level)
+    {
+        SIMD::SetLevel(static_cast<SIMD::Level>(level));
+
+        QuaternionBatch::Multiply(from.Stream(), to.Stream(), result.Stream(), Count);
+        for (size_t i = 0; i < Count; ++i) VOSGI_CHECK(Distance(result.At(i), Quaternion::Multiply(from.At(i), to.At(i))) < 1e-5f);
+
+        QuaternionBatch::Slerp(from.Stream(), to.Stream(), t.data(), result.Stream(), Count);
+        for (size_t i = 0; i < Count; ++i) VOSGI_CHECK(Distance(result.At(i), ReferenceSlerp(from.At(i), to.At(i), t[i])) < 1e-4f);
+
+        QuaternionBatch::Rotate(to.Stream(), {pointX.data(), pointY.data(), pointZ.data()}, {outX.data(), outY.data(), outZ.data()}, Count);
+        for (size_t i = 0; i < Count; ++i)
+        {
+            const glm::vec3 point = Quaternion::Multiply(to.At(i), glm::vec3(pointX[i], pointY[i], pointZ[i]));
+            VOSGI_CHECK(std::abs(point.x - outX[i]) + std::abs(point.y - outY[i]) + std::abs(point.z - outZ[i]) < 1e-5f);
+        }
+
+        TransformBatch::ComposeTRS(trs, 0, Count, matrices.data());
+        for (size_t i = 0; i < Count; ++i)
+        {
+            const glm::mat4 matrix = matrices[i].ToMat4();
+            for (int column = 0; column < 4; ++column)
+            {
+                for (int row = 0; row < 4; ++row) VOSGI_CHECK(std::abs(matrix[column][row] - referenceMatrices[i][column][row]) < 1e-5f);
+            }
+        }
+
+        const double multiply = Test::Measure(Runs, [&] { QuaternionBatch::Multiply(from.Stream(), to.Stream(), result.Stream(), Count); });
+        const double slerp = Test::Measure(Runs, [&] { QuaternionBatch::Slerp(from.Stream(), to.Stream(), t.data(), result.Stream(), Count); });
+        const double rotate = Test::Measure(Runs, [&] {
+            QuaternionBatch::Rotate(to.Stream(), {pointX.data(), pointY.data(), pointZ.data()}, {outX.data(), outY.data(), outZ.data()}, Count);
+        });
+        const double compose = Test::Measure(Runs, [&] { TransformBatch::ComposeTRS(trs, 0, Count, matrices.data()); });
+
+        std::printf("%-10s multiply %6.2f  slerp %6.2f  rotate %6.2f  compose %6.2f\n", SIMD::GetLevelName(SIMD::GetLevel()),
+                    PerElement(multiply), PerElement(slerp), PerElement(rotate), PerElement(compose));
+    }
+    return 0;
+}